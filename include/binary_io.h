@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+// Raw binary I/O for the frozen containers and spill files; `V` must be
+// trivially copyable.
+template<class V>
+void write_binary(std::ostream &out, const V *data, std::size_t count) {
+    static_assert(std::is_trivially_copyable_v<V>, "Only trivially copyable data can be written as bytes");
+    out.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(count * sizeof(V)));
+}
+
+template<class V>
+void read_binary(std::istream &in, V *data, std::size_t count) {
+    static_assert(std::is_trivially_copyable_v<V>, "Only trivially copyable data can be read as bytes");
+    if (!in.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(count * sizeof(V)))) {
+        throw std::runtime_error("Truncated data");
+    }
+}
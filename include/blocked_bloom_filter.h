@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Split-block Bloom filter: every key maps to one 64-byte block and sets one bit
+// in each of its eight words, so a query reads a single cache line. With 16 bits
+// per key the false positive rate is about 0.1%. Keys are given as 64-bit hashes
+// that should already be well mixed.
+class BlockedBloomFilter {
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type default_bits_per_key = 16;
+
+private:
+    struct alignas(64) Block {
+        std::uint64_t words[8];
+    };
+
+    static constexpr std::uint32_t salts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                               0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+    std::vector<Block> blocks;
+
+    [[nodiscard]] const Block &block_of(std::uint64_t hash) const noexcept {
+        return blocks[(hash >> 32) % blocks.size()];
+    }
+
+    static std::uint64_t bit(std::uint64_t hash, size_type word) noexcept {
+        return std::uint64_t(1) << ((static_cast<std::uint32_t>(hash) * salts[word]) >> 26);
+    }
+
+public:
+    explicit BlockedBloomFilter(size_type expected_keys = 0, size_type bits_per_key = default_bits_per_key) {
+        reset(expected_keys, bits_per_key);
+    }
+
+    // Empties the filter and sizes it for `expected_keys` keys.
+    void reset(size_type expected_keys, size_type bits_per_key = default_bits_per_key) {
+        size_type count = (expected_keys * bits_per_key + 511) / 512;
+        blocks.assign(count > 0 ? count : 1, Block{});
+    }
+
+    void insert(std::uint64_t hash) noexcept {
+        Block &block = blocks[(hash >> 32) % blocks.size()];
+        for (size_type i = 0; i < 8; ++i) {
+            block.words[i] |= bit(hash, i);
+        }
+    }
+
+    // `false` means the key was never inserted; `true` may be a false positive.
+    [[nodiscard]] bool may_contain(std::uint64_t hash) const noexcept {
+        const Block &block = block_of(hash);
+        for (size_type i = 0; i < 8; ++i) {
+            if ((block.words[i] & bit(hash, i)) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] size_type bit_count() const noexcept {
+        return blocks.size() * 512;
+    }
+
+    // Expected false positive rate given the current fill: a query hits a set bit
+    // in all eight words with probability (fill)^8.
+    [[nodiscard]] double estimated_fpr() const noexcept {
+        size_type set = 0;
+        for (const auto &block : blocks) {
+            for (auto word : block.words) {
+                for (; word != 0; word &= word - 1) {
+                    ++set;
+                }
+            }
+        }
+        double fill = static_cast<double>(set) / bit_count();
+        double fpr = 1;
+        for (int i = 0; i < 8; ++i) {
+            fpr *= fill;
+        }
+        return fpr;
+    }
+};
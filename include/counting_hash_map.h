@@ -0,0 +1,216 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Map from keys to counters that many threads can update at once without a lock.
+// Slots hold an atomic key and an atomic counter: a new key claims an empty slot
+// with a compare-and-swap, and `increment` is a `fetch_add` on the counter. Keys
+// are never moved or removed, so the table is sized once for the capacity given
+// at construction; `increment` throws `std::length_error` for a new key once
+// that many keys are present. Like DenseHashSet, one key value is reserved to
+// mark empty slots.
+template<
+        class Key,
+        class Integer = std::size_t,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>
+>
+class CountingHashMap {
+    static_assert(std::atomic<Key>::is_always_lock_free, "Keys must fit in a lock-free atomic");
+    static_assert(std::is_integral_v<Integer>, "Counters must be integers");
+
+public:
+    using key_type = Key;
+    using mapped_type = Integer;
+    using value_type = std::pair<Key, Integer>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+
+private:
+    struct Slot {
+        std::atomic<Key> key;
+        std::atomic<Integer> count{0};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_type slot_count;
+    std::atomic<size_type> el_count{0};
+    std::atomic<size_type> claimed{0};
+    key_type empty_marker;
+    hasher hash_fn;
+
+    // Returns the slot of `key`, or `nullptr` if it is absent.
+    [[nodiscard]] Slot *find_slot(const key_type &key) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        for (size_type i = 0; i < slot_count; ++i) {
+            Key current = slots[cur].key.load(std::memory_order_acquire);
+            if (current == key) {
+                return &slots[cur];
+            }
+            if (current == empty_marker) {
+                return nullptr;
+            }
+            cur = (ind + probing_local.next()) % slot_count;
+        }
+        return nullptr;
+    }
+
+    // Returns the slot of `key`, claiming an empty one if it is absent; `nullptr`
+    // if the table already holds `capacity()` keys. A new key reserves its place
+    // in `el_count` before it claims a slot, so the load never exceeds 1/2;
+    // `claimed` counts the reservations that have claimed their slot.
+    Slot *claim(const key_type &key) {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        for (size_type i = 0; i < slot_count; ++i) {
+            Slot &slot = slots[cur];
+            Key current = slot.key.load(std::memory_order_acquire);
+            while (current == empty_marker) {
+                if (el_count.fetch_add(1, std::memory_order_relaxed) < capacity()) {
+                    if (slot.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                        claimed.fetch_add(1, std::memory_order_release);
+                        return &slot;
+                    }
+                    // Another thread claimed the slot first; `current` is its key.
+                    el_count.fetch_sub(1, std::memory_order_relaxed);
+                } else {
+                    el_count.fetch_sub(1, std::memory_order_relaxed);
+                    // A reservation may belong to a thread that is about to claim this
+                    // very slot, possibly for the same key, so the table is full only
+                    // once every reservation has claimed its slot.
+                    bool full = claimed.load(std::memory_order_acquire) >= capacity();
+                    current = slot.key.load(std::memory_order_acquire);
+                    if (current == empty_marker) {
+                        if (full) {
+                            return nullptr;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            if (current == key) {
+                return &slot;
+            }
+            cur = (ind + probing_local.next()) % slot_count;
+        }
+        return nullptr;
+    }
+
+public:
+    // Room for `capacity` keys, at a load factor of at most 1/2.
+    CountingHashMap(const key_type &empty_key,
+                    size_type capacity,
+                    const hasher &hash = hasher()) : slots(new Slot[capacity * 2 + 1]),
+                                                     slot_count(capacity * 2 + 1),
+                                                     empty_marker(empty_key), hash_fn(hash) {
+        for (size_type i = 0; i < slot_count; ++i) {
+            slots[i].key.store(empty_marker, std::memory_order_relaxed);
+        }
+    }
+
+    CountingHashMap(const CountingHashMap &) = delete;
+
+    CountingHashMap &operator=(const CountingHashMap &) = delete;
+
+    // Adds `delta` to the counter of `key`, inserting it with 0 first if needed,
+    // and returns the new value. Safe to call from any number of threads.
+    Integer increment(const key_type &key, Integer delta = 1) {
+        if (key == empty_marker) {
+            throw std::invalid_argument("Trying to use a reserved key as an element");
+        }
+        Slot *slot = claim(key);
+        if (slot == nullptr) {
+            throw std::length_error("CountingHashMap is full");
+        }
+        return slot->count.fetch_add(delta, std::memory_order_relaxed) + delta;
+    }
+
+    // Current counter of `key`, 0 if it was never incremented.
+    [[nodiscard]] Integer get(const key_type &key) const {
+        Slot *slot = find_slot(key);
+        return slot == nullptr ? 0 : slot->count.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return find_slot(key) != nullptr;
+    }
+
+    // Calls `callback(key, count)` for every key. Concurrent increments may or may
+    // not be reflected, but every key inserted before the call is visited.
+    template<class Callback>
+    void for_each(Callback callback) const {
+        for (size_type i = 0; i < slot_count; ++i) {
+            Key key = slots[i].key.load(std::memory_order_acquire);
+            if (key != empty_marker) {
+                callback(key, slots[i].count.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    [[nodiscard]] std::vector<value_type> snapshot() const {
+        std::vector<value_type> result;
+        result.reserve(size());
+        for_each([&](const Key &key, Integer count) {
+            result.emplace_back(key, count);
+        });
+        return result;
+    }
+
+    // The `k` keys with the largest counters, largest first.
+    [[nodiscard]] std::vector<value_type> top_k(size_type k) const {
+        auto result = snapshot();
+        auto by_count = [](const value_type &a, const value_type &b) {
+            return a.second > b.second;
+        };
+        k = std::min(k, result.size());
+        std::partial_sort(result.begin(), result.begin() + k, result.end(), by_count);
+        result.resize(k);
+        return result;
+    }
+
+    // Not safe while other threads are incrementing.
+    void clear() noexcept {
+        for (size_type i = 0; i < slot_count; ++i) {
+            slots[i].key.store(empty_marker, std::memory_order_relaxed);
+            slots[i].count.store(0, std::memory_order_relaxed);
+        }
+        el_count.store(0, std::memory_order_relaxed);
+        claimed.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return claimed.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type capacity() const noexcept {
+        return slot_count / 2;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return slot_count;
+    }
+
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return apply_hash(hash_fn, key) % slot_count;
+    }
+
+    [[nodiscard]] const key_type &empty_key() const noexcept {
+        return empty_marker;
+    }
+};
@@ -0,0 +1,493 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Map counterpart of DenseHashSet: keys live in a plain array with user-reserved
+// `empty_key` and `deleted_key` values, mapped values in a parallel array of the
+// same length, so probing never touches the values. `T` must be default constructible.
+// Both arrays come from `Allocator`, rebound to `Key` and `T`.
+template<
+        class Key,
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>,
+        class Allocator = std::allocator<std::pair<const Key, T>>
+>
+class DenseHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+    using reference = std::pair<const Key &, T &>;
+    using const_reference = std::pair<const Key &, const T &>;
+
+private:
+    using key_container = std::vector<Key, typename std::allocator_traits<Allocator>::template rebind_alloc<Key>>;
+    using value_container = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+
+    key_container keys;
+    value_container values;
+    size_type el_count;
+    size_type del_count;
+    key_type empty_marker;
+    key_type deleted_marker;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    template<class Map, class Ref>
+    class Basic_Iterator {
+        friend class DenseHashMap;
+
+        template<class, class>
+        friend class Basic_Iterator;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef std::pair<const Key, T> value_type;
+        typedef Ref reference;
+
+        struct pointer {
+            Ref ref;
+
+            Ref *operator->() noexcept {
+                return &ref;
+            }
+        };
+
+    private:
+        Map *map = nullptr;
+        size_type current{};
+
+        Basic_Iterator(Map *m, size_type ind) : map(m), current(ind) {
+            skip_free();
+        }
+
+        void skip_free() noexcept {
+            while (current < map->bucket_count() && !map->is_live(current)) {
+                ++current;
+            }
+        }
+
+        [[nodiscard]] bool at_end() const noexcept {
+            return map == nullptr || current >= map->bucket_count();
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        template<class OtherMap, class OtherRef>
+        Basic_Iterator(const Basic_Iterator<OtherMap, OtherRef> &other) : map(other.map), current(other.current) {}
+
+        reference operator*() const {
+            if (!at_end()) {
+                return reference(map->keys[current], map->values[current]);
+            }
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+
+        pointer operator->() const {
+            return pointer{operator*()};
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (!at_end()) {
+                ++current;
+                skip_free();
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator==(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return at_end() ? other.at_end() : !other.at_end() && current == other.current;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator!=(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return !(*this == other);
+        }
+    };
+
+public:
+    using iterator = Basic_Iterator<DenseHashMap, reference>;
+    using const_iterator = Basic_Iterator<const DenseHashMap, const_reference>;
+
+    DenseHashMap(const key_type &empty_key,
+                 const key_type &deleted_key,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal(),
+                 const allocator_type &alloc = allocator_type()) : keys(expected_max_size * 2 + 1, empty_key,
+                                                                        typename key_container::allocator_type(alloc)),
+                                                                   values(expected_max_size * 2 + 1,
+                                                                          typename value_container::allocator_type(alloc)),
+                                                         el_count(0), del_count(0),
+                                                         empty_marker(empty_key), deleted_marker(deleted_key),
+                                                         hash_fn(hash), equal_fn(equal) {
+        if (equal_fn(empty_marker, deleted_marker)) {
+            throw std::invalid_argument("Empty and deleted keys must differ");
+        }
+    }
+
+    template<class InputIt>
+    DenseHashMap(InputIt first, InputIt last,
+                 const key_type &empty_key,
+                 const key_type &deleted_key,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal(),
+                 const allocator_type &alloc = allocator_type()) : DenseHashMap(empty_key, deleted_key,
+                                                                                expected_max_size, hash, equal,
+                                                                                alloc) {
+        insert(first, last);
+    }
+
+    DenseHashMap(const DenseHashMap &) = default;
+
+    // Leaves `other` empty and without buckets; it grows again on insertion.
+    DenseHashMap(DenseHashMap &&other) noexcept : keys(std::move(other.keys)), values(std::move(other.values)),
+                                                  el_count(std::exchange(other.el_count, 0)),
+                                                  del_count(std::exchange(other.del_count, 0)),
+                                                  empty_marker(other.empty_marker), deleted_marker(other.deleted_marker),
+                                                  hash_fn(std::move(other.hash_fn)), equal_fn(std::move(other.equal_fn)) {
+        other.keys.clear();
+        other.values.clear();
+    }
+
+    DenseHashMap &operator=(const DenseHashMap &) = default;
+
+    DenseHashMap &operator=(DenseHashMap &&other) noexcept {
+        if (this != &other) {
+            swap(other);
+            other.keys.clear();
+            other.values.clear();
+            other.el_count = 0;
+            other.del_count = 0;
+        }
+        return *this;
+    }
+
+    void swap(DenseHashMap &other) noexcept {
+        std::swap(keys, other.keys);
+        std::swap(values, other.values);
+        std::swap(el_count, other.el_count);
+        std::swap(del_count, other.del_count);
+        std::swap(empty_marker, other.empty_marker);
+        std::swap(deleted_marker, other.deleted_marker);
+        std::swap(hash_fn, other.hash_fn);
+        std::swap(equal_fn, other.equal_fn);
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator();
+    }
+
+    const_iterator end() const noexcept {
+        return cend();
+    }
+
+    const_iterator cend() const noexcept {
+        return const_iterator();
+    }
+
+private:
+    [[nodiscard]] bool is_live(size_type ind) const {
+        return !equal_fn(keys[ind], empty_marker) && !equal_fn(keys[ind], deleted_marker);
+    }
+
+    void check_key(const key_type &key) const {
+        if (equal_fn(key, empty_marker) || equal_fn(key, deleted_marker)) {
+            throw std::invalid_argument("Trying to use a reserved key as an element");
+        }
+    }
+
+    // Returns the slot holding `key` and `true`, or the first reusable slot on its
+    // probe sequence and `false`; `bucket_count()` means the sequence is exhausted.
+    [[nodiscard]] std::pair<size_type, bool> locate(const key_type &key) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        size_type reusable = bucket_count();
+        for (size_type i = 0; i < bucket_count(); ++i) {
+            if (equal_fn(keys[cur], empty_marker)) {
+                return {reusable == bucket_count() ? cur : reusable, false};
+            }
+            if (equal_fn(keys[cur], deleted_marker)) {
+                if (reusable == bucket_count()) {
+                    reusable = cur;
+                }
+            } else if (equal_fn(keys[cur], key)) {
+                return {cur, true};
+            }
+            cur = (ind + probing_local.next()) % bucket_count();
+        }
+        return {reusable, false};
+    }
+
+    void rebuild(size_type count) {
+        // A moved-from table has no slots; growing it from there starts at one.
+        count = std::max<size_type>(count, 1);
+        key_container old_keys(count, empty_marker, keys.get_allocator());
+        value_container old_values(count, values.get_allocator());
+        std::swap(keys, old_keys);
+        std::swap(values, old_values);
+        el_count = 0;
+        del_count = 0;
+        for (size_type i = 0; i < old_keys.size(); ++i) {
+            if (!equal_fn(old_keys[i], empty_marker) && !equal_fn(old_keys[i], deleted_marker)) {
+                auto place = locate(old_keys[i]);
+                if (place.first == bucket_count()) {
+                    rebuild(bucket_count() * 3);
+                    place = locate(old_keys[i]);
+                }
+                keys[place.first] = std::move(old_keys[i]);
+                values[place.first] = std::move(old_values[i]);
+                ++el_count;
+            }
+        }
+    }
+
+    // Finds `key` or claims a slot for it; the mapped value of a claimed slot is
+    // left for the caller to assign.
+    template<class K>
+    std::pair<size_type, bool> claim(K &&key) {
+        check_key(key);
+        if ((size() + del_count + 1) * 2 > bucket_count()) {
+            rebuild((size() + 1) * 2 > bucket_count() ? bucket_count() * 3 : bucket_count());
+        }
+        while (true) {
+            auto place = locate(key);
+            if (place.second) {
+                return {place.first, false};
+            }
+            if (place.first != bucket_count()) {
+                if (equal_fn(keys[place.first], deleted_marker)) {
+                    --del_count;
+                }
+                keys[place.first] = std::forward<K>(key);
+                ++el_count;
+                return {place.first, true};
+            }
+            rebuild(bucket_count() * 3);
+        }
+    }
+
+public:
+    std::pair<iterator, bool> insert(const value_type &inserted_value) {
+        return try_emplace(inserted_value.first, inserted_value.second);
+    }
+
+    template<class P>
+    std::pair<iterator, bool> insert(P &&inserted_value) {
+        return try_emplace(std::forward<P>(inserted_value).first, std::forward<P>(inserted_value).second);
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    template<class K, class M>
+    std::pair<iterator, bool> insert_or_assign(K &&key, M &&inserted_value) {
+        auto place = claim(std::forward<K>(key));
+        values[place.first] = std::forward<M>(inserted_value);
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args &&... args) {
+        auto place = claim(std::forward<K>(key));
+        if (place.second) {
+            values[place.first] = mapped_type(std::forward<Args>(args)...);
+        }
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> emplace(K &&key, Args &&... args) {
+        return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    iterator erase(const_iterator pos) {
+        if (pos == cend()) {
+            return end();
+        }
+        keys[pos.current] = deleted_marker;
+        values[pos.current] = mapped_type();
+        ++del_count;
+        --el_count;
+        return iterator(this, pos.current);
+    }
+
+    size_type erase(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            return 0;
+        }
+        erase(const_iterator(this, place.first));
+        return 1;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] iterator find(const key_type &key) {
+        auto place = locate(key);
+        return place.second ? iterator(this, place.first) : end();
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        auto place = locate(key);
+        return place.second ? const_iterator(this, place.first) : cend();
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return locate(key).second;
+    }
+
+    mapped_type &at(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return values[place.first];
+    }
+
+    const mapped_type &at(const key_type &key) const {
+        auto place = locate(key);
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return values[place.first];
+    }
+
+    mapped_type &operator[](const key_type &key) {
+        return values[try_emplace(key).first.current];
+    }
+
+    mapped_type &operator[](key_type &&key) {
+        return values[try_emplace(std::move(key)).first.current];
+    }
+
+    void clear() {
+        std::fill(keys.begin(), keys.end(), empty_marker);
+        std::fill(values.begin(), values.end(), mapped_type());
+        el_count = 0;
+        del_count = 0;
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const {
+        return allocator_type(keys.get_allocator());
+    }
+
+    [[nodiscard]] const key_type &empty_key() const noexcept {
+        return empty_marker;
+    }
+
+    [[nodiscard]] const key_type &deleted_key() const noexcept {
+        return deleted_marker;
+    }
+
+    [[nodiscard]] size_type bucket_size(const size_type) const noexcept {
+        return 1;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return keys.size();
+    }
+
+    [[nodiscard]] size_type max_bucket_count() const noexcept {
+        return keys.max_size();
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return max_bucket_count() / 2;
+    }
+
+    // A moved-from table has no slots; every key then maps to the (absent) slot 0.
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return bucket_count() == 0 ? 0 : apply_hash(hash_fn, key) % bucket_count();
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return static_cast<float>(size()) / bucket_count();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 0.5;
+    }
+
+    void rehash(const size_type count) {
+        if (count > bucket_count() || del_count > size()) {
+            rebuild(std::max(bucket_count(), count));
+        }
+    }
+
+    void reserve(size_type count) {
+        rehash(count * 2 + 1);
+    }
+
+    friend bool operator==(const DenseHashMap &first, const DenseHashMap &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (auto it = first.begin(); it != first.end(); ++it) {
+            auto place = second.locate(it->first);
+            if (!place.second || !(second.values[place.first] == it->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const DenseHashMap &first, const DenseHashMap &second) {
+        return !(first == second);
+    }
+};
@@ -0,0 +1,432 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Open addressing set without per-slot metadata: the table is a plain array of keys,
+// two of which (`empty_key` and `deleted_key`) are reserved by the user to mark free
+// and erased slots, so for `int` every slot costs exactly 4 bytes. `Allocator`
+// provides the slot array, e.g. a HugePageAllocator for very large tables.
+template<
+        class Key,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>,
+        class Allocator = std::allocator<Key>
+>
+class DenseHashSet {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using allocator_type = Allocator;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using pointer = value_type *;
+    using const_pointer = const value_type *;
+
+private:
+    typedef typename std::vector<Key, Allocator> container;
+    container data;
+    size_type el_count;
+    size_type del_count;
+    key_type empty_marker;
+    key_type deleted_marker;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    class Basic_Iterator {
+        friend class DenseHashSet;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef const Key value_type;
+        typedef value_type *pointer;
+        typedef value_type &reference;
+
+    private:
+        const DenseHashSet *set = nullptr;
+        size_type current{};
+
+        Basic_Iterator(const DenseHashSet *s, size_type ind) : set(s), current(ind) {
+            skip_free();
+        }
+
+        void skip_free() noexcept {
+            while (current < set->bucket_count() && !set->is_live(current)) {
+                ++current;
+            }
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        reference operator*() const {
+            if (set != nullptr && current < set->bucket_count()) {
+                return set->data[current];
+            }
+            throw std::out_of_range("Trying to access a value of the end iterator");
+        }
+
+        pointer operator->() const {
+            return &operator*();
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (set != nullptr && current < set->bucket_count()) {
+                ++current;
+                skip_free();
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            bool end1 = it1.set == nullptr || it1.current >= it1.set->bucket_count();
+            bool end2 = it2.set == nullptr || it2.current >= it2.set->bucket_count();
+            return end1 ? end2 : !end2 && it1.current == it2.current;
+        }
+
+        friend bool operator!=(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            return !(it1 == it2);
+        }
+    };
+
+public:
+    using const_iterator = Basic_Iterator;
+    using iterator = const_iterator;
+
+    DenseHashSet(const key_type &empty_key,
+                 const key_type &deleted_key,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal(),
+                 const allocator_type &alloc = allocator_type()) : data(expected_max_size * 2 + 1, empty_key, alloc),
+                                                         el_count(0), del_count(0),
+                                                         empty_marker(empty_key), deleted_marker(deleted_key),
+                                                         hash_fn(hash), equal_fn(equal) {
+        if (equal_fn(empty_marker, deleted_marker)) {
+            throw std::invalid_argument("Empty and deleted keys must differ");
+        }
+    }
+
+    template<class InputIt>
+    DenseHashSet(InputIt first, InputIt last,
+                 const key_type &empty_key,
+                 const key_type &deleted_key,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal(),
+                 const allocator_type &alloc = allocator_type()) : DenseHashSet(empty_key, deleted_key,
+                                                                                expected_max_size, hash, equal,
+                                                                                alloc) {
+        insert(first, last);
+    }
+
+    DenseHashSet(const DenseHashSet &) = default;
+
+    // Leaves `other` empty and without buckets; it grows again on insertion.
+    DenseHashSet(DenseHashSet &&other) noexcept : data(std::move(other.data)),
+                                                  el_count(std::exchange(other.el_count, 0)),
+                                                  del_count(std::exchange(other.del_count, 0)),
+                                                  empty_marker(other.empty_marker), deleted_marker(other.deleted_marker),
+                                                  hash_fn(std::move(other.hash_fn)), equal_fn(std::move(other.equal_fn)) {
+        other.data.clear();
+    }
+
+    DenseHashSet &operator=(const DenseHashSet &) = default;
+
+    DenseHashSet &operator=(DenseHashSet &&other) noexcept {
+        if (this != &other) {
+            swap(other);
+            other.data.clear();
+            other.el_count = 0;
+            other.del_count = 0;
+        }
+        return *this;
+    }
+
+    void swap(DenseHashSet &other) noexcept {
+        std::swap(data, other.data);
+        std::swap(el_count, other.el_count);
+        std::swap(del_count, other.del_count);
+        std::swap(empty_marker, other.empty_marker);
+        std::swap(deleted_marker, other.deleted_marker);
+        std::swap(hash_fn, other.hash_fn);
+        std::swap(equal_fn, other.equal_fn);
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    [[nodiscard]] const_iterator cbegin() const noexcept {
+        return Basic_Iterator(this, 0);
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        return cend();
+    }
+
+    [[nodiscard]] const_iterator cend() const noexcept {
+        return Basic_Iterator();
+    }
+
+private:
+    [[nodiscard]] bool is_live(size_type ind) const {
+        return !equal_fn(data[ind], empty_marker) && !equal_fn(data[ind], deleted_marker);
+    }
+
+    void check_key(const key_type &key) const {
+        if (equal_fn(key, empty_marker) || equal_fn(key, deleted_marker)) {
+            throw std::invalid_argument("Trying to use a reserved key as an element");
+        }
+    }
+
+    // Returns the slot holding `key` and `true`, or the first reusable slot on its
+    // probe sequence and `false`; `bucket_count()` means the sequence is exhausted.
+    [[nodiscard]] std::pair<size_type, bool> locate(const key_type &key) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        size_type reusable = bucket_count();
+        for (size_type i = 0; i < bucket_count(); ++i) {
+            if (equal_fn(data[cur], empty_marker)) {
+                return {reusable == bucket_count() ? cur : reusable, false};
+            }
+            if (equal_fn(data[cur], deleted_marker)) {
+                if (reusable == bucket_count()) {
+                    reusable = cur;
+                }
+            } else if (equal_fn(data[cur], key)) {
+                return {cur, true};
+            }
+            cur = (ind + probing_local.next()) % bucket_count();
+        }
+        return {reusable, false};
+    }
+
+    void rebuild(size_type count) {
+        // A moved-from table has no slots; growing it from there starts at one.
+        count = std::max<size_type>(count, 1);
+        container t(count, empty_marker, data.get_allocator());
+        std::swap(data, t);
+        el_count = 0;
+        del_count = 0;
+        for (auto &key : t) {
+            if (!equal_fn(key, empty_marker) && !equal_fn(key, deleted_marker)) {
+                auto place = locate(key);
+                if (place.first == bucket_count()) {
+                    rebuild(bucket_count() * 3);
+                    place = locate(key);
+                }
+                data[place.first] = std::move(key);
+                ++el_count;
+            }
+        }
+    }
+
+    template<class K>
+    std::pair<iterator, bool> insert_key(K &&key) {
+        check_key(key);
+        if ((size() + del_count + 1) * 2 > bucket_count()) {
+            rebuild((size() + 1) * 2 > bucket_count() ? bucket_count() * 3 : bucket_count());
+        }
+        while (true) {
+            auto place = locate(key);
+            if (place.second) {
+                return std::make_pair(Basic_Iterator(this, place.first), false);
+            }
+            if (place.first != bucket_count()) {
+                if (equal_fn(data[place.first], deleted_marker)) {
+                    --del_count;
+                }
+                data[place.first] = std::forward<K>(key);
+                ++el_count;
+                return std::make_pair(Basic_Iterator(this, place.first), true);
+            }
+            rebuild(bucket_count() * 3);
+        }
+    }
+
+public:
+    std::pair<iterator, bool> insert(const value_type &key) {
+        return insert_key(key);
+    }
+
+    std::pair<iterator, bool> insert(value_type &&key) {
+        return insert_key(std::move(key));
+    }
+
+    iterator insert(const_iterator, const value_type &key) {
+        return insert(key).first;
+    }
+
+    iterator insert(const_iterator, value_type &&key) {
+        return insert(std::move(key)).first;
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> emplace(Args &&... args) {
+        return insert_key(key_type(std::forward<Args>(args)...));
+    }
+
+    template<class... Args>
+    iterator emplace_hint(const_iterator, Args &&... args) {
+        return emplace(std::forward<Args>(args)...).first;
+    }
+
+    iterator erase(const_iterator pos) {
+        if (pos == cend()) {
+            return pos;
+        }
+        data[pos.current] = deleted_marker;
+        ++del_count;
+        --el_count;
+        return ++pos;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        while (first != last) {
+            first = erase(first);
+        }
+        return first;
+    }
+
+    size_type erase(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            return 0;
+        }
+        data[place.first] = deleted_marker;
+        ++del_count;
+        --el_count;
+        return 1;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        auto place = locate(key);
+        return place.second ? Basic_Iterator(this, place.first) : cend();
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return locate(key).second;
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+        auto it = find(key);
+        return {it, it == cend() ? it : std::next(it)};
+    }
+
+    void clear() noexcept {
+        std::fill(data.begin(), data.end(), empty_marker);
+        el_count = 0;
+        del_count = 0;
+    }
+
+    [[nodiscard]] allocator_type get_allocator() const {
+        return data.get_allocator();
+    }
+
+    [[nodiscard]] const key_type &empty_key() const noexcept {
+        return empty_marker;
+    }
+
+    [[nodiscard]] const key_type &deleted_key() const noexcept {
+        return deleted_marker;
+    }
+
+    [[nodiscard]] size_type bucket_size(const size_type) const noexcept {
+        return 1;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return data.size();
+    }
+
+    [[nodiscard]] size_type max_bucket_count() const noexcept {
+        return data.max_size();
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return max_bucket_count() / 2;
+    }
+
+    // A moved-from table has no slots; every key then maps to the (absent) slot 0.
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return bucket_count() == 0 ? 0 : apply_hash(hash_fn, key) % bucket_count();
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return static_cast<float>(size()) / bucket_count();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 0.5;
+    }
+
+    void rehash(const size_type count) {
+        if (count > bucket_count() || del_count > size()) {
+            rebuild(std::max(bucket_count(), count));
+        }
+    }
+
+    void reserve(size_type count) {
+        rehash(count * 2 + 1);
+    }
+
+    friend bool operator==(const DenseHashSet &first, const DenseHashSet &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (auto it = first.begin(); it != first.end(); ++it) {
+            if (!second.contains(*it)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const DenseHashSet &first, const DenseHashSet &second) {
+        return !(first == second);
+    }
+};
@@ -0,0 +1,185 @@
+#pragma once
+
+#include "hash_map.h"
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+// HashMap whose entries expire a fixed time after they were written. Deadlines
+// are stored as 32-bit millisecond offsets from the map's epoch next to the value.
+// Expired entries read as absent right away and are reclaimed lazily when looked
+// up, plus a few slots per operation by an incremental sweeper that erases through
+// the regular tombstone path.
+template<
+        class Key,
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>,
+        class Clock = std::chrono::steady_clock
+>
+class ExpiringHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using clock = Clock;
+    using duration = std::chrono::milliseconds;
+
+private:
+    using ticks = std::uint32_t;
+
+    // Offsets are rebased before they reach the top bit, so deadlines up to
+    // `max_ttl` ahead always fit.
+    static constexpr ticks rebase_threshold = std::numeric_limits<ticks>::max() / 2;
+    static constexpr ticks max_ttl = std::numeric_limits<ticks>::max() / 2;
+
+    struct Entry {
+        T value;
+        ticks deadline;
+    };
+
+    HashMap<Key, Entry, CollisionPolicy, Hash, Equal> table;
+    typename Clock::time_point epoch;
+    duration default_ttl;
+    size_type cursor = 0;
+    size_type budget = 8;
+
+    ticks now() {
+        auto elapsed = std::chrono::duration_cast<duration>(Clock::now() - epoch).count();
+        if (elapsed >= rebase_threshold) {
+            rebase(static_cast<ticks>(elapsed));
+            elapsed = 0;
+        }
+        return static_cast<ticks>(elapsed);
+    }
+
+    // Moves the epoch forward by `shift` ticks so that offsets never overflow.
+    void rebase(ticks shift) {
+        epoch += duration(shift);
+        for (auto it = table.begin(); it != table.end(); ++it) {
+            ticks &deadline = it->second.deadline;
+            deadline = deadline > shift ? deadline - shift : 0;
+        }
+    }
+
+    ticks deadline_after(ticks current, duration ttl) const {
+        auto count = std::max<typename duration::rep>(ttl.count(), 0);
+        return current + static_cast<ticks>(std::min<typename duration::rep>(count, max_ttl));
+    }
+
+    size_type step(ticks current) {
+        return table.sweep(cursor, budget, [current](const auto &value) {
+            return value.second.deadline <= current;
+        });
+    }
+
+public:
+    explicit ExpiringHashMap(duration ttl,
+                             size_type expected_max_size = 0,
+                             const hasher &hash = hasher(),
+                             const key_equal &equal = key_equal()) : table(expected_max_size, hash, equal),
+                                                                     epoch(Clock::now()), default_ttl(ttl) {}
+
+    // Inserts or overwrites `key` with a deadline `ttl` from now. Returns `true`
+    // if no live entry for `key` existed.
+    template<class M>
+    bool insert_or_assign(const key_type &key, M &&value, duration ttl) {
+        ticks current = now();
+        step(current);
+        auto it = table.find(key);
+        bool inserted = it == table.end() || it->second.deadline <= current;
+        table.insert_or_assign(key, Entry{mapped_type(std::forward<M>(value)), deadline_after(current, ttl)});
+        return inserted;
+    }
+
+    template<class M>
+    bool insert_or_assign(const key_type &key, M &&value) {
+        return insert_or_assign(key, std::forward<M>(value), default_ttl);
+    }
+
+    // Returns the value of a live entry, or `nullptr` if `key` is absent or expired.
+    mapped_type *find(const key_type &key) {
+        ticks current = now();
+        step(current);
+        auto it = table.find(key);
+        if (it == table.end()) {
+            return nullptr;
+        }
+        if (it->second.deadline <= current) {
+            table.erase(it);
+            return nullptr;
+        }
+        return &it->second.value;
+    }
+
+    bool contains(const key_type &key) {
+        return find(key) != nullptr;
+    }
+
+    // Pushes the deadline of a live entry to `ttl` from now.
+    bool touch(const key_type &key, duration ttl) {
+        ticks current = now();
+        auto it = table.find(key);
+        if (it == table.end() || it->second.deadline <= current) {
+            return false;
+        }
+        it->second.deadline = deadline_after(current, ttl);
+        return true;
+    }
+
+    bool touch(const key_type &key) {
+        return touch(key, default_ttl);
+    }
+
+    bool erase(const key_type &key) {
+        return table.erase(key) != 0;
+    }
+
+    // Runs the sweeper over `slots` slots outside of regular operations, e.g. from
+    // an idle loop. Returns the number of entries reclaimed.
+    size_type sweep(size_type slots) {
+        return table.sweep(cursor, slots, [current = now()](const auto &value) {
+            return value.second.deadline <= current;
+        });
+    }
+
+    // Number of slots the sweeper visits per insert or lookup.
+    void set_sweep_budget(size_type slots) noexcept {
+        budget = slots;
+    }
+
+    [[nodiscard]] size_type sweep_budget() const noexcept {
+        return budget;
+    }
+
+    template<class Callback>
+    void for_each(Callback callback) {
+        ticks current = now();
+        for (auto it = table.begin(); it != table.end(); ++it) {
+            if (it->second.deadline > current) {
+                callback(it->first, it->second.value);
+            }
+        }
+    }
+
+    void clear() noexcept {
+        table.clear();
+        cursor = 0;
+    }
+
+    // Entries not reclaimed yet, expired ones included.
+    [[nodiscard]] size_type size() const noexcept {
+        return table.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] duration ttl() const noexcept {
+        return default_ttl;
+    }
+};
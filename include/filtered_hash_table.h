@@ -0,0 +1,272 @@
+#pragma once
+
+#include "blocked_bloom_filter.h"
+#include "hash_functions.h"
+#include "hash_map.h"
+#include "hash_set.h"
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+// Puts a BlockedBloomFilter in front of a HashSet or HashMap, so that most
+// lookups of absent keys are answered from one cache line without walking the
+// probe sequence. Insertions add to the filter. Erased keys cannot be removed
+// from it; the filter is rebuilt from the table when the table is rehashed or
+// purged of tombstones, or when erased keys outnumber live ones.
+template<class Table>
+class FilteredHashTable {
+public:
+    using table_type = Table;
+    using key_type = typename Table::key_type;
+    using value_type = typename Table::value_type;
+    using size_type = typename Table::size_type;
+    using hasher = typename Table::hasher;
+    using key_equal = typename Table::key_equal;
+    using iterator = typename Table::iterator;
+    using const_iterator = typename Table::const_iterator;
+
+    struct Stats {
+        size_type lookups = 0;
+        // Lookups the filter answered without touching the table.
+        size_type filtered = 0;
+        // Lookups the filter let through for keys that were absent.
+        size_type false_positives = 0;
+        size_type rebuilds = 0;
+        // Observed rate: false positives among all lookups of absent keys.
+        double fpr = 0;
+        // Rate expected from the current filter fill.
+        double estimated_fpr = 0;
+    };
+
+private:
+    Table table;
+    BlockedBloomFilter filter;
+    hasher filter_hash;
+    size_type filtered_buckets = 0;
+    size_type stale = 0;
+    size_type bits_per_key = BlockedBloomFilter::default_bits_per_key;
+    mutable Stats counters;
+
+    template<class V>
+    static const key_type &key_of(const V &value) {
+        if constexpr (std::is_same_v<std::decay_t<V>, key_type>) {
+            return value;
+        } else {
+            return value.first;
+        }
+    }
+
+    [[nodiscard]] std::uint64_t key_hash(const key_type &key) const {
+        return hash_mix(apply_hash(filter_hash, key));
+    }
+
+    // Keeps the filter in step with the table after a mutation.
+    void sync() {
+        if (table.bucket_count() != filtered_buckets || stale > table.size()) {
+            rebuild_filter();
+        }
+    }
+
+    template<class Result>
+    Result added(Result result) {
+        if constexpr (std::is_same_v<Result, iterator>) {
+            filter.insert(key_hash(key_of(*result)));
+        } else {
+            filter.insert(key_hash(key_of(*result.first)));
+        }
+        sync();
+        return result;
+    }
+
+    // Shared by both `find` overloads; `Self` is `const` for the const one.
+    template<class Self>
+    static auto lookup(Self &self, const key_type &key) {
+        ++self.counters.lookups;
+        if (!self.filter.may_contain(self.key_hash(key))) {
+            ++self.counters.filtered;
+            return self.table.end();
+        }
+        auto it = self.table.find(key);
+        if (it == self.table.end()) {
+            ++self.counters.false_positives;
+        }
+        return it;
+    }
+
+public:
+    explicit FilteredHashTable(size_type expected_max_size = 0,
+                               const hasher &hash = hasher(),
+                               const key_equal &equal = key_equal()) : table(expected_max_size, hash, equal),
+                                                                       filter_hash(hash) {
+        rebuild_filter();
+        counters.rebuilds = 0;
+    }
+
+    // Takes over an existing table and builds the filter for its elements.
+    explicit FilteredHashTable(Table &&source) : table(std::move(source)), filter_hash(table.hash_function()) {
+        rebuild_filter();
+        counters.rebuilds = 0;
+    }
+
+    // Refills the filter from the live elements, sized for the table's capacity.
+    void rebuild_filter() {
+        filter.reset(std::max(table.bucket_count(), table.size()), bits_per_key);
+        for (auto it = table.begin(); it != table.end(); ++it) {
+            filter.insert(key_hash(key_of(*it)));
+        }
+        filtered_buckets = table.bucket_count();
+        stale = 0;
+        ++counters.rebuilds;
+    }
+
+    // Filter size per table slot; more bits lower the false positive rate.
+    void set_bits_per_key(size_type bits) {
+        bits_per_key = bits;
+        rebuild_filter();
+    }
+
+    iterator begin() noexcept {
+        return table.begin();
+    }
+
+    const_iterator begin() const noexcept {
+        return table.begin();
+    }
+
+    iterator end() noexcept {
+        return table.end();
+    }
+
+    const_iterator end() const noexcept {
+        return table.end();
+    }
+
+    auto insert(const value_type &value) {
+        return added(table.insert(value));
+    }
+
+    auto insert(value_type &&value) {
+        return added(table.insert(std::move(value)));
+    }
+
+    template<class... Args>
+    auto emplace(Args &&... args) {
+        return added(table.emplace(std::forward<Args>(args)...));
+    }
+
+    template<class K, class M>
+    auto insert_or_assign(K &&key, M &&value) {
+        return added(table.insert_or_assign(std::forward<K>(key), std::forward<M>(value)));
+    }
+
+    template<class K, class... Args>
+    auto try_emplace(K &&key, Args &&... args) {
+        return added(table.try_emplace(std::forward<K>(key), std::forward<Args>(args)...));
+    }
+
+    template<class K>
+    auto &operator[](K &&key) {
+        return added(table.try_emplace(std::forward<K>(key))).first->second;
+    }
+
+    size_type erase(const key_type &key) {
+        size_type counter = table.erase(key);
+        stale += counter;
+        sync();
+        return counter;
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return find(key) != table.end();
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] iterator find(const key_type &key) {
+        return lookup(*this, key);
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        return lookup(*this, key);
+    }
+
+    void clear() {
+        table.clear();
+        rebuild_filter();
+    }
+
+    void rehash(size_type count) {
+        table.rehash(count);
+        rebuild_filter();
+    }
+
+    void reserve(size_type count) {
+        table.reserve(count);
+        sync();
+    }
+
+    void compact() {
+        table.compact();
+        rebuild_filter();
+    }
+
+    void shrink_to_fit() {
+        table.shrink_to_fit();
+        rebuild_filter();
+    }
+
+    [[nodiscard]] Stats stats() const {
+        Stats result = counters;
+        size_type negatives = counters.filtered + counters.false_positives;
+        result.fpr = negatives == 0 ? 0 : static_cast<double>(counters.false_positives) / negatives;
+        result.estimated_fpr = filter.estimated_fpr();
+        return result;
+    }
+
+    void reset_stats() noexcept {
+        size_type rebuilds = counters.rebuilds;
+        counters = Stats();
+        counters.rebuilds = rebuilds;
+    }
+
+    // The underlying table, for read-only use; mutating it directly would leave
+    // the filter out of date.
+    [[nodiscard]] const Table &unfiltered() const noexcept {
+        return table;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return table.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return table.empty();
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return table.bucket_count();
+    }
+
+    [[nodiscard]] size_type filter_bits() const noexcept {
+        return filter.bit_count();
+    }
+};
+
+template<
+        class Key,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+using FilteredHashSet = FilteredHashTable<HashSet<Key, CollisionPolicy, Hash, Equal>>;
+
+template<
+        class Key,
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+using FilteredHashMap = FilteredHashTable<HashMap<Key, T, CollisionPolicy, Hash, Equal>>;
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "binary_io.h"
+#include "hash_map.h"
+#include "perfect_hash.h"
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// Read-only map over a fixed set of keys. Its slots are indexed by a minimal
+// perfect hash, so the table has no empty slots and a lookup is exactly one slot
+// access and one key comparison. Building takes a few passes over the keys;
+// duplicate keys keep their first value. A frozen map of trivially copyable keys
+// and values can be saved and loaded back as raw bytes, which requires a hasher
+// that gives the same results in every process (not SipHash).
+template<
+        class Key,
+        class T,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class FrozenHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using const_reference = std::pair<const Key &, const T &>;
+    using reference = const_reference;
+
+private:
+    static constexpr std::uint64_t magic = 0x314d5a4f52464148ULL;  // "HAFROZM1"
+
+    PerfectHash index;
+    std::vector<Key> keys;
+    std::vector<T> values;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    class Basic_Iterator {
+        friend class FrozenHashMap;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef std::pair<const Key, T> value_type;
+        typedef const_reference reference;
+
+        struct pointer {
+            const_reference ref;
+
+            const const_reference *operator->() const noexcept {
+                return &ref;
+            }
+        };
+
+    private:
+        const FrozenHashMap *map = nullptr;
+        size_type current{};
+
+        Basic_Iterator(const FrozenHashMap *m, size_type ind) : map(m), current(ind) {}
+
+        [[nodiscard]] bool at_end() const noexcept {
+            return map == nullptr || current >= map->size();
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        reference operator*() const {
+            if (!at_end()) {
+                return reference(map->keys[current], map->values[current]);
+            }
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+
+        pointer operator->() const {
+            return pointer{operator*()};
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (!at_end()) {
+                ++current;
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            return it1.at_end() ? it2.at_end() : !it2.at_end() && it1.current == it2.current;
+        }
+
+        friend bool operator!=(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            return !(it1 == it2);
+        }
+    };
+
+    [[nodiscard]] std::uint64_t key_hash(const key_type &key) const {
+        return apply_hash(hash_fn, key);
+    }
+
+    // Lays out the distinct elements of `source` in perfect hash order.
+    template<class Source>
+    void build(Source &&source) {
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(source.size());
+        for (const auto &element : source) {
+            hashes.push_back(key_hash(element.first));
+        }
+        auto distinct = distinct_by_hash(hashes, [&](size_type a, size_type b) {
+            return equal_fn(source[a].first, source[b].first);
+        });
+        std::vector<std::uint64_t> distinct_hashes;
+        distinct_hashes.reserve(distinct.size());
+        for (size_type i : distinct) {
+            distinct_hashes.push_back(hashes[i]);
+        }
+        index = PerfectHash(distinct_hashes);
+        std::vector<size_type> element_at(distinct.size());
+        for (size_type i = 0; i < distinct.size(); ++i) {
+            element_at[index(distinct_hashes[i])] = distinct[i];
+        }
+        keys.reserve(distinct.size());
+        values.reserve(distinct.size());
+        for (size_type i : element_at) {
+            keys.push_back(std::move(source[i].first));
+            values.push_back(std::move(source[i].second));
+        }
+    }
+
+public:
+    using iterator = Basic_Iterator;
+    using const_iterator = Basic_Iterator;
+
+    explicit FrozenHashMap(const hasher &hash = hasher(), const key_equal &equal = key_equal())
+            : hash_fn(hash), equal_fn(equal) {}
+
+    template<class InputIt>
+    FrozenHashMap(InputIt first, InputIt last,
+                  const hasher &hash = hasher(),
+                  const key_equal &equal = key_equal()) : FrozenHashMap(hash, equal) {
+        std::vector<std::pair<Key, T>> source;
+        for (auto it = first; it != last; ++it) {
+            source.emplace_back((*it).first, (*it).second);
+        }
+        build(source);
+    }
+
+    FrozenHashMap(std::initializer_list<value_type> init,
+                  const hasher &hash = hasher(),
+                  const key_equal &equal = key_equal()) : FrozenHashMap(init.begin(), init.end(), hash, equal) {}
+
+    template<class CollisionPolicy>
+    explicit FrozenHashMap(const HashMap<Key, T, CollisionPolicy, Hash, Equal> &map,
+                           const hasher &hash = hasher(),
+                           const key_equal &equal = key_equal()) : FrozenHashMap(map.begin(), map.end(),
+                                                                                 hash, equal) {}
+
+    const_iterator begin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator end() const noexcept {
+        return const_iterator();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        if (empty()) {
+            return end();
+        }
+        size_type slot = index(key_hash(key));
+        return equal_fn(keys[slot], key) ? const_iterator(this, slot) : end();
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return find(key) != end();
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    const mapped_type &at(const key_type &key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return values[it.current];
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return keys.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return size();
+    }
+
+    [[nodiscard]] float load_factor() const noexcept {
+        return empty() ? 0 : 1;
+    }
+
+    // Writes the perfect hash, keys and values as raw bytes.
+    void save(std::ostream &out) const {
+        std::uint64_t header[2] = {magic, size()};
+        write_binary(out, header, 2);
+        index.save(out);
+        write_binary(out, keys.data(), keys.size());
+        write_binary(out, values.data(), values.size());
+    }
+
+    // Reads a map written by `save` with the same key, value and hasher types.
+    static FrozenHashMap load(std::istream &in,
+                              const hasher &hash = hasher(),
+                              const key_equal &equal = key_equal()) {
+        std::uint64_t header[2];
+        read_binary(in, header, 2);
+        if (header[0] != magic) {
+            throw std::runtime_error("Not a frozen hash map");
+        }
+        FrozenHashMap result(hash, equal);
+        result.index = PerfectHash::load(in);
+        if (result.index.size() != header[1]) {
+            throw std::runtime_error("Corrupt frozen hash map");
+        }
+        result.keys.resize(header[1]);
+        result.values.resize(header[1]);
+        read_binary(in, result.keys.data(), result.keys.size());
+        read_binary(in, result.values.data(), result.values.size());
+        return result;
+    }
+
+    friend bool operator==(const FrozenHashMap &first, const FrozenHashMap &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (size_type i = 0; i < first.size(); ++i) {
+            auto el = second.find(first.keys[i]);
+            if (el == second.end() || !(el->second == first.values[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const FrozenHashMap &first, const FrozenHashMap &second) {
+        return !(first == second);
+    }
+};
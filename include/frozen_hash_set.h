@@ -0,0 +1,186 @@
+#pragma once
+
+#include "binary_io.h"
+#include "hash_set.h"
+#include "perfect_hash.h"
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+// Read-only set over a fixed set of keys, laid out by a minimal perfect hash:
+// no empty slots, and a lookup is one slot access and one key comparison. Sets
+// of trivially copyable keys can be saved and loaded back as raw bytes, given a
+// hasher that gives the same results in every process (not SipHash).
+template<
+        class Key,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class FrozenHashSet {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+    using pointer = const value_type *;
+    using const_pointer = const value_type *;
+    using iterator = typename std::vector<Key>::const_iterator;
+    using const_iterator = iterator;
+
+private:
+    static constexpr std::uint64_t magic = 0x31535a4f52464148ULL;  // "HAFROZS1"
+
+    PerfectHash index;
+    std::vector<Key> keys;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    [[nodiscard]] std::uint64_t key_hash(const key_type &key) const {
+        return apply_hash(hash_fn, key);
+    }
+
+    // Lays out the distinct keys of `source` in perfect hash order.
+    void build(std::vector<Key> &source) {
+        std::vector<std::uint64_t> hashes;
+        hashes.reserve(source.size());
+        for (const auto &key : source) {
+            hashes.push_back(key_hash(key));
+        }
+        auto distinct = distinct_by_hash(hashes, [&](size_type a, size_type b) {
+            return equal_fn(source[a], source[b]);
+        });
+        std::vector<std::uint64_t> distinct_hashes;
+        distinct_hashes.reserve(distinct.size());
+        for (size_type i : distinct) {
+            distinct_hashes.push_back(hashes[i]);
+        }
+        index = PerfectHash(distinct_hashes);
+        std::vector<size_type> element_at(distinct.size());
+        for (size_type i = 0; i < distinct.size(); ++i) {
+            element_at[index(distinct_hashes[i])] = distinct[i];
+        }
+        keys.reserve(distinct.size());
+        for (size_type i : element_at) {
+            keys.push_back(std::move(source[i]));
+        }
+    }
+
+public:
+    explicit FrozenHashSet(const hasher &hash = hasher(), const key_equal &equal = key_equal())
+            : hash_fn(hash), equal_fn(equal) {}
+
+    template<class InputIt>
+    FrozenHashSet(InputIt first, InputIt last,
+                  const hasher &hash = hasher(),
+                  const key_equal &equal = key_equal()) : FrozenHashSet(hash, equal) {
+        std::vector<Key> source(first, last);
+        build(source);
+    }
+
+    FrozenHashSet(std::initializer_list<value_type> init,
+                  const hasher &hash = hasher(),
+                  const key_equal &equal = key_equal()) : FrozenHashSet(init.begin(), init.end(), hash, equal) {}
+
+    template<class CollisionPolicy>
+    explicit FrozenHashSet(const HashSet<Key, CollisionPolicy, Hash, Equal> &set,
+                           const hasher &hash = hasher(),
+                           const key_equal &equal = key_equal()) : FrozenHashSet(set.begin(), set.end(),
+                                                                                 hash, equal) {}
+
+    const_iterator begin() const noexcept {
+        return keys.begin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    const_iterator end() const noexcept {
+        return keys.end();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        if (empty()) {
+            return end();
+        }
+        size_type slot = index(key_hash(key));
+        return equal_fn(keys[slot], key) ? begin() + slot : end();
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return find(key) != end();
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return keys.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return size();
+    }
+
+    [[nodiscard]] float load_factor() const noexcept {
+        return empty() ? 0 : 1;
+    }
+
+    // Writes the perfect hash and the keys as raw bytes.
+    void save(std::ostream &out) const {
+        std::uint64_t header[2] = {magic, size()};
+        write_binary(out, header, 2);
+        index.save(out);
+        write_binary(out, keys.data(), keys.size());
+    }
+
+    // Reads a set written by `save` with the same key and hasher types.
+    static FrozenHashSet load(std::istream &in,
+                              const hasher &hash = hasher(),
+                              const key_equal &equal = key_equal()) {
+        std::uint64_t header[2];
+        read_binary(in, header, 2);
+        if (header[0] != magic) {
+            throw std::runtime_error("Not a frozen hash set");
+        }
+        FrozenHashSet result(hash, equal);
+        result.index = PerfectHash::load(in);
+        if (result.index.size() != header[1]) {
+            throw std::runtime_error("Corrupt frozen hash set");
+        }
+        result.keys.resize(header[1]);
+        read_binary(in, result.keys.data(), result.keys.size());
+        return result;
+    }
+
+    friend bool operator==(const FrozenHashSet &first, const FrozenHashSet &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (const auto &key : first.keys) {
+            if (!second.contains(key)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const FrozenHashSet &first, const FrozenHashSet &second) {
+        return !(first == second);
+    }
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "hash_functions.h"
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Bounded cache on an open addressing table with CLOCK eviction. Each slot carries
+// a reference bit that lookups set and the clock hand clears; the first entry found
+// with a clear bit is evicted. The table is sized once for `capacity` entries at a
+// load factor of 1/2 and uses linear probing with backward-shift deletion, so it
+// accumulates no tombstones and never rehashes.
+template<
+        class Key,
+        class T,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class HashCache {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+    struct Stats {
+        size_type hits = 0;
+        size_type misses = 0;
+        size_type evictions = 0;
+    };
+
+private:
+    struct Slot {
+        std::optional<std::pair<Key, T>> entry;
+        bool referenced = false;
+    };
+
+    std::vector<Slot> slots;
+    size_type max_entries;
+    size_type el_count = 0;
+    size_type hand = 0;
+    Stats counters;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    // A moved-from cache has no slots until its next insertion.
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return slots.empty() ? 0 : apply_hash(hash_fn, key) % slots.size();
+    }
+
+    // Returns the slot holding `key` and `true`, or the empty slot ending its
+    // probe sequence and `false`.
+    [[nodiscard]] std::pair<size_type, bool> locate(const key_type &key) const {
+        if (slots.empty()) {
+            return {0, false};
+        }
+        size_type cur = bucket(key);
+        while (slots[cur].entry.has_value()) {
+            if (equal_fn(slots[cur].entry->first, key)) {
+                return {cur, true};
+            }
+            cur = (cur + 1) % slots.size();
+        }
+        return {cur, false};
+    }
+
+    // Empties `hole` and shifts the following entries of its cluster back so that
+    // every remaining entry stays reachable from its home slot.
+    void erase_slot(size_type hole) {
+        size_type cur = hole;
+        while (true) {
+            cur = (cur + 1) % slots.size();
+            if (!slots[cur].entry.has_value()) {
+                break;
+            }
+            size_type home = bucket(slots[cur].entry->first);
+            bool stays = hole <= cur ? (hole < home && home <= cur) : (hole < home || home <= cur);
+            if (!stays) {
+                slots[hole].entry = std::move(slots[cur].entry);
+                slots[hole].referenced = slots[cur].referenced;
+                hole = cur;
+            }
+        }
+        slots[hole].entry.reset();
+        slots[hole].referenced = false;
+        --el_count;
+    }
+
+    void evict() {
+        while (true) {
+            Slot &slot = slots[hand];
+            if (slot.entry.has_value()) {
+                if (!slot.referenced) {
+                    erase_slot(hand);
+                    ++counters.evictions;
+                    return;
+                }
+                slot.referenced = false;
+            }
+            hand = (hand + 1) % slots.size();
+        }
+    }
+
+    // Finds `key` or makes room for it; a new entry's slot is returned with
+    // `true` and must be filled by the caller.
+    std::pair<size_type, bool> claim(const key_type &key) {
+        if (slots.empty()) {
+            slots.resize(max_entries * 2 + 1);
+        }
+        auto place = locate(key);
+        if (place.second) {
+            return {place.first, false};
+        }
+        if (el_count == max_entries) {
+            evict();
+            place = locate(key);
+        }
+        ++el_count;
+        return {place.first, true};
+    }
+
+public:
+    explicit HashCache(size_type capacity,
+                       const hasher &hash = hasher(),
+                       const key_equal &equal = key_equal()) : slots(capacity * 2 + 1), max_entries(capacity),
+                                                               hash_fn(hash), equal_fn(equal) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Cache capacity must be positive");
+        }
+    }
+
+    HashCache(const HashCache &) = default;
+
+    // Steals the entries of `other`, which is left empty with the same capacity
+    // and allocates its slots again on its next insertion.
+    HashCache(HashCache &&other) noexcept : slots(std::move(other.slots)), max_entries(other.max_entries),
+                                            el_count(std::exchange(other.el_count, 0)),
+                                            hand(std::exchange(other.hand, 0)),
+                                            counters(std::exchange(other.counters, Stats())),
+                                            hash_fn(other.hash_fn), equal_fn(other.equal_fn) {
+        other.slots.clear();
+    }
+
+    HashCache &operator=(const HashCache &) = default;
+
+    HashCache &operator=(HashCache &&other) noexcept {
+        if (this != &other) {
+            slots = std::move(other.slots);
+            max_entries = other.max_entries;
+            el_count = std::exchange(other.el_count, 0);
+            hand = std::exchange(other.hand, 0);
+            counters = std::exchange(other.counters, Stats());
+            hash_fn = other.hash_fn;
+            equal_fn = other.equal_fn;
+            other.slots.clear();
+        }
+        return *this;
+    }
+
+    // Returns the cached value and marks it as recently used, or `nullptr`.
+    // Counts a hit or a miss.
+    mapped_type *find(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            ++counters.misses;
+            return nullptr;
+        }
+        ++counters.hits;
+        slots[place.first].referenced = true;
+        return &slots[place.first].entry->second;
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return locate(key).second;
+    }
+
+    // Inserts or overwrites `key`, evicting an entry if the cache is full.
+    // Returns `true` if the key was not cached before.
+    template<class M>
+    bool insert_or_assign(const key_type &key, M &&value) {
+        auto place = claim(key);
+        Slot &slot = slots[place.first];
+        if (place.second) {
+            slot.entry.emplace(key, std::forward<M>(value));
+        } else {
+            slot.entry->second = std::forward<M>(value);
+        }
+        slot.referenced = true;
+        return place.second;
+    }
+
+    // Constructs a value for `key` unless it is already cached.
+    template<class... Args>
+    std::pair<mapped_type *, bool> try_emplace(const key_type &key, Args &&... args) {
+        auto place = claim(key);
+        Slot &slot = slots[place.first];
+        if (place.second) {
+            slot.entry.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        }
+        slot.referenced = true;
+        return {&slot.entry->second, place.second};
+    }
+
+    bool erase(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            return false;
+        }
+        erase_slot(place.first);
+        return true;
+    }
+
+    void clear() noexcept {
+        for (auto &slot : slots) {
+            slot.entry.reset();
+            slot.referenced = false;
+        }
+        el_count = 0;
+        hand = 0;
+    }
+
+    [[nodiscard]] const Stats &stats() const noexcept {
+        return counters;
+    }
+
+    void reset_stats() noexcept {
+        counters = Stats();
+    }
+
+    [[nodiscard]] float hit_ratio() const noexcept {
+        size_type lookups = counters.hits + counters.misses;
+        return lookups == 0 ? 0 : static_cast<float>(counters.hits) / lookups;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type capacity() const noexcept {
+        return max_entries;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return slots.size();
+    }
+};
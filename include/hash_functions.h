@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// 64-bit finalizer (murmur3 fmix64): every input bit affects every output bit,
+// so sequential and strided keys spread over the whole table.
+constexpr std::uint64_t hash_mix(std::uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Inverse of `hash_mix`: the shifts are undone by repeating them and the
+// multiplications by the inverses of the constants modulo 2^64.
+constexpr std::uint64_t hash_unmix(std::uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0x9cb4b2f8129337dbULL;
+    x ^= x >> 33;
+    x *= 0x4f74430c22a54005ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// Byte-string hash processing 8 bytes per step with a multiply-xor round,
+// followed by the same finalizer as integer keys.
+inline std::uint64_t hash_bytes(const void *ptr, std::size_t len, std::uint64_t seed = 0) noexcept {
+    const auto *p = static_cast<const unsigned char *>(ptr);
+    std::uint64_t h = seed ^ (len * 0x9e3779b97f4a7c15ULL);
+    while (len >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ hash_mix(word)) * 0x9fb21c651e98df25ULL;
+        h ^= h >> 29;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, p, len);
+        h = (h ^ hash_mix(word ^ len)) * 0x9fb21c651e98df25ULL;
+    }
+    return hash_mix(h);
+}
+
+// Library hasher: integers and enums go through `hash_mix`, strings through
+// `hash_bytes`. A non-zero seed gives an independent hash family.
+template<class Key, class Enable = void>
+struct FastHash;
+
+template<class Key>
+struct FastHash<Key, std::enable_if_t<std::is_integral_v<Key> || std::is_enum_v<Key>>> {
+    std::uint64_t seed;
+
+    explicit FastHash(std::uint64_t s = 0) : seed(s) {}
+
+    std::size_t operator()(Key key) const noexcept {
+        return hash_mix(static_cast<std::uint64_t>(key) ^ seed);
+    }
+};
+
+template<class Key>
+struct FastHash<Key *> {
+    std::uint64_t seed;
+
+    explicit FastHash(std::uint64_t s = 0) : seed(s) {}
+
+    std::size_t operator()(Key *key) const noexcept {
+        return hash_mix(reinterpret_cast<std::uintptr_t>(key) ^ seed);
+    }
+};
+
+template<>
+struct FastHash<std::string_view> {
+    std::uint64_t seed;
+
+    explicit FastHash(std::uint64_t s = 0) : seed(s) {}
+
+    std::size_t operator()(std::string_view key) const noexcept {
+        return hash_bytes(key.data(), key.size(), seed);
+    }
+};
+
+template<>
+struct FastHash<std::string> : FastHash<std::string_view> {
+    using FastHash<std::string_view>::FastHash;
+};
+
+// SipHash-1-3 keyed with a 128-bit secret: without the key an attacker cannot
+// construct colliding inputs.
+inline std::uint64_t siphash(const void *ptr, std::size_t len, std::uint64_t k0, std::uint64_t k1) noexcept {
+    const auto *p = static_cast<const unsigned char *>(ptr);
+    std::uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+    std::uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+    std::uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+    std::uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+    auto rotl = [](std::uint64_t x, int b) {
+        return (x << b) | (x >> (64 - b));
+    };
+    auto round = [&]() {
+        v0 += v1;
+        v1 = rotl(v1, 13);
+        v1 ^= v0;
+        v0 = rotl(v0, 32);
+        v2 += v3;
+        v3 = rotl(v3, 16);
+        v3 ^= v2;
+        v0 += v3;
+        v3 = rotl(v3, 21);
+        v3 ^= v0;
+        v2 += v1;
+        v1 = rotl(v1, 17);
+        v1 ^= v2;
+        v2 = rotl(v2, 32);
+    };
+    std::uint64_t last = static_cast<std::uint64_t>(len) << 56;
+    for (; len >= 8; p += 8, len -= 8) {
+        std::uint64_t m;
+        std::memcpy(&m, p, 8);
+        v3 ^= m;
+        round();
+        v0 ^= m;
+    }
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, p, len);
+    last |= tail;
+    v3 ^= last;
+    round();
+    v0 ^= last;
+    v2 ^= 0xff;
+    round();
+    round();
+    round();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Hasher usable in constant expressions, for tables built at compile time:
+// integers and enums go through `hash_mix`, strings through 64-bit FNV-1a and
+// then `hash_mix`. Slower than `FastHash` on long strings.
+constexpr std::uint64_t fnv1a(std::string_view str) noexcept {
+    std::uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : str) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+template<class Key>
+struct StaticHash {
+    constexpr std::size_t operator()(const Key &key) const noexcept {
+        if constexpr (std::is_convertible_v<const Key &, std::string_view>) {
+            return hash_mix(fnv1a(std::string_view(key)));
+        } else if constexpr (std::is_enum_v<Key>) {
+            return hash_mix(static_cast<std::uint64_t>(static_cast<std::underlying_type_t<Key>>(key)));
+        } else {
+            static_assert(std::is_integral_v<Key>, "StaticHash supports integral, enum and string keys");
+            return hash_mix(static_cast<std::uint64_t>(key));
+        }
+    }
+};
+
+// Keyed hasher for hardened tables. Every instance draws its own random key, and
+// `reseed` draws a new one; the tables call it when they detect flooding.
+template<class Key>
+class SipHash {
+    std::uint64_t k0;
+    std::uint64_t k1;
+
+    template<class K>
+    static std::uint64_t as_integer(const K &key) {
+        if constexpr (std::is_enum_v<K>) {
+            return static_cast<std::uint64_t>(static_cast<std::underlying_type_t<K>>(key));
+        } else {
+            return static_cast<std::uint64_t>(key);
+        }
+    }
+
+public:
+    SipHash() {
+        reseed();
+    }
+
+    SipHash(std::uint64_t key0, std::uint64_t key1) : k0(key0), k1(key1) {}
+
+    void reseed() {
+        std::random_device rd;
+        k0 = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+        k1 = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+    }
+
+    std::size_t operator()(const Key &key) const noexcept {
+        if constexpr (std::is_convertible_v<const Key &, std::string_view>) {
+            std::string_view view = key;
+            return siphash(view.data(), view.size(), k0, k1);
+        } else {
+            static_assert(std::is_integral_v<Key> || std::is_enum_v<Key>,
+                          "SipHash supports integral, enum and string keys");
+            std::uint64_t value = as_integer(key);
+            return siphash(&value, sizeof(value), k0, k1);
+        }
+    }
+};
+
+template<class Hash, class = void>
+struct is_reseedable : std::false_type {};
+
+template<class Hash>
+struct is_reseedable<Hash, std::void_t<decltype(std::declval<Hash &>().reseed())>> : std::true_type {};
+
+// Hashers whose output is too regular to be reduced modulo the bucket count
+// directly. The tables pass their result through `hash_mix` first; specialize
+// this for your own hashers to opt in.
+template<class Hash>
+struct is_weak_hash : std::false_type {};
+
+template<class Key>
+struct is_weak_hash<std::hash<Key>>
+        : std::bool_constant<std::is_integral_v<Key> || std::is_enum_v<Key> || std::is_pointer_v<Key>> {};
+
+template<class Hash, class Key>
+inline std::size_t apply_hash(const Hash &hash, const Key &key) {
+    if constexpr (is_weak_hash<Hash>::value) {
+        return hash_mix(hash(key));
+    } else {
+        return hash(key);
+    }
+}
@@ -1,8 +1,12 @@
 #pragma once
 
 #include <iostream>
+#include "hash_functions.h"
+#include "interleaved_probe.h"
 #include "policy.h"
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 template<
@@ -32,17 +36,33 @@ private:
     struct Bucket {
         value_type value;
         bool is_deleted;
+        std::uint8_t generation = 0;
 
         template<class... Args>
         explicit Bucket(Args &&... args) : value(std::forward<Args>(args)...), is_deleted(false) {}
     };
 
-    typedef typename std::vector<std::unique_ptr<Bucket>> container;
+    // The slot array, and the generation that live buckets are tagged with: a
+    // bucket from an older generation was dropped by `epoch_clear` and reads as
+    // an empty slot.
+    struct Slots : std::vector<std::unique_ptr<Bucket>> {
+        using std::vector<std::unique_ptr<Bucket>>::vector;
+
+        std::uint8_t generation = 0;
+
+        [[nodiscard]] bool vacant(size_type i) const noexcept {
+            const Bucket *b = (*this)[i].get();
+            return b == nullptr || b->generation != generation;
+        }
+    };
+
+    typedef Slots container;
     container data;
     size_type el_count;
     size_type del_count;
     hasher hash_fn;
     key_equal equal_fn;
+    float min_load = 0;
 
 
     class ConstIterator;
@@ -80,6 +100,8 @@ private:
                                                starting_pos(other.starting_pos),
                                                iterator_end(other.iterator_end), is_ordered(false) {}
 
+        Iterator &operator=(const Iterator &other) = default;
+
     private:
         explicit Iterator(const container *cont, size_type ind = 0) : values(cont), current(ind),
                                                                       starting_pos(ind),
@@ -87,7 +109,7 @@ private:
             if (current >= values->size()) {
                 iterator_end = true;
             } else {
-                while ((*values)[current].get() == nullptr || (*values)[current]->is_deleted) {
+                while (values->vacant(current) || (*values)[current]->is_deleted) {
                     current = (current + 1) % values->size();
                     if (current == starting_pos) {
                         iterator_end = true;
@@ -136,7 +158,7 @@ private:
                             iterator_end = true;
                             break;
                         }
-                    } while ((*values)[current].get() == nullptr || (*values)[current]->is_deleted);
+                    } while (values->vacant(current) || (*values)[current]->is_deleted);
                 }
             }
             return *this;
@@ -206,6 +228,8 @@ private:
                                                     starting_pos(other.starting_pos),
                                                     iterator_end(other.iterator_end), is_ordered(false) {}
 
+        ConstIterator &operator=(const ConstIterator &other) = default;
+
     private:
         explicit ConstIterator(const container *cont, size_type ind = 0) : values(cont), current(ind),
                                                                            starting_pos(ind),
@@ -213,7 +237,7 @@ private:
             if (current >= values->size()) {
                 iterator_end = true;
             } else {
-                while ((*values)[current].get() == nullptr || (*values)[current]->is_deleted) {
+                while (values->vacant(current) || (*values)[current]->is_deleted) {
                     current = (current + 1) % values->size();
                     if (current == starting_pos) {
                         iterator_end = true;
@@ -262,7 +286,7 @@ private:
                             iterator_end = true;
                             break;
                         }
-                    } while ((*values)[current].get() == nullptr || (*values)[current]->is_deleted);
+                    } while (values->vacant(current) || (*values)[current]->is_deleted);
                 }
             }
             return *this;
@@ -289,89 +313,60 @@ public:
 
     explicit HashMap(size_type expected_max_size = 0,
                      const hasher &hash = hasher(),
-                     const key_equal &equal = key_equal()) : data(),
+                     const key_equal &equal = key_equal()) : data(expected_max_size + 1),
                                                              el_count(0),
-                                                             del_count(0), hash_fn(hash), equal_fn(equal) {
-        for (size_type i = 0; i < expected_max_size + 1; ++i) {
-            data.push_back(nullptr);
-        }
-    }
+                                                             del_count(0), hash_fn(hash), equal_fn(equal) {}
 
     template<class InputIt>
     HashMap(InputIt first, InputIt last,
             size_type expected_max_size = 0,
             const hasher &hash = hasher(),
-            const key_equal &equal = key_equal()) {
-        HashMap(expected_max_size, hash, equal);
+            const key_equal &equal = key_equal()) : HashMap(expected_max_size, hash, equal) {
         insert(first, last);
     }
 
-    HashMap(const HashMap &other) {
-        hash_fn = other.hash_fn;
-        equal_fn = other.equal_fn;
-        el_count = other.el_count;
-        del_count = other.del_count;
-        data.clear();
+    // Copies keep the slot layout of `other`, tombstones included, so no element
+    // has to be probed for again.
+    HashMap(const HashMap &other) : data(other.bucket_count()),
+                                    el_count(other.el_count), del_count(other.del_count),
+                                    hash_fn(other.hash_fn), equal_fn(other.equal_fn), min_load(other.min_load) {
+        data.generation = other.data.generation;
         for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (auto it = other.cbegin(); it != other.cend(); ++it) {
-            data[it.current] = std::make_unique<Bucket>(*it);
+            if (!other.data.vacant(i)) {
+                data[i] = std::make_unique<Bucket>(std::as_const(*other.data[i]));
+            }
         }
     }
 
-    HashMap(HashMap &&other) {
-        el_count = std::move(other.el_count);
-        del_count = 0;
-        hash_fn = std::move(other.hash_fn);
-        equal_fn = std::move(other.equal_fn);
-        data.clear();
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            if (other.data[i].get() != nullptr && !other.data[i]->is_deleted) {
-                data[i] = std::move(other.data[i]);
-            }
-        }
+    // Steals the table of `other`, which is left empty.
+    HashMap(HashMap &&other) noexcept : data(std::move(other.data)),
+                                        el_count(std::exchange(other.el_count, 0)),
+                                        del_count(std::exchange(other.del_count, 0)),
+                                        hash_fn(std::move(other.hash_fn)), equal_fn(std::move(other.equal_fn)),
+                                        min_load(other.min_load) {
+        other.data.clear();
     }
 
     HashMap(std::initializer_list<value_type> init,
             size_type expected_max_size = 0,
             const hasher &hash = hasher(),
-            const key_equal &equal = key_equal()) {
-        HashMap(expected_max_size, hash, equal);
+            const key_equal &equal = key_equal()) : HashMap(expected_max_size, hash, equal) {
         insert(init);
     }
 
     HashMap &operator=(const HashMap &other) {
-        hash_fn = other.hash_fn;
-        equal_fn = other.equal_fn;
-        el_count = other.el_count;
-        del_count = other.del_count;
-        data.clear();
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (auto it = other.cbegin(); it != other.cend(); ++it) {
-            data[it.current] = std::make_unique<Bucket>(*it);
+        if (this != &other) {
+            swap(HashMap(other));
         }
         return *this;
     }
 
     HashMap &operator=(HashMap &&other) noexcept {
-        el_count = std::move(other.el_count);
-        del_count = 0;
-        hash_fn = std::move(other.hash_fn);
-        equal_fn = std::move(other.equal_fn);
-        data.clear();
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            if (other.data[i].get() != nullptr && !other.data[i]->is_deleted) {
-                data[i] = std::move(other.data[i]);
-            }
+        if (this != &other) {
+            swap(std::move(other));
+            other.data.clear();
+            other.el_count = 0;
+            other.del_count = 0;
         }
         return *this;
     }
@@ -388,6 +383,7 @@ public:
         std::swap(hash_fn, other.hash_fn);
         std::swap(el_count, other.el_count);
         std::swap(del_count, other.del_count);
+        std::swap(min_load, other.min_load);
     }
 
     iterator begin() noexcept {
@@ -415,29 +411,71 @@ public:
     }
 
 private:
-    void force_insert_ptr(std::unique_ptr<Bucket> ptr) {
+    // Longest probe sequence an insertion walks before the table is grown; keyed
+    // hashers get a logarithmic bound so that flooding is detected early.
+    [[nodiscard]] size_type probe_limit() const noexcept {
+        if constexpr (is_reseedable<hasher>::value) {
+            size_type limit = 16;
+            for (size_type n = bucket_count(); n > 1; n >>= 1) {
+                limit += 4;
+            }
+            return std::min(limit, bucket_count() / 2 + 1);
+        }
+        return bucket_count() / 2;
+    }
+
+    // Called when an insertion runs out of probes. A long probe sequence in a
+    // sparse table means colliding keys, so a keyed hasher is re-seeded instead
+    // of tripling the table.
+    void grow() {
+        if constexpr (is_reseedable<hasher>::value) {
+            if (size() < bucket_count() / 2) {
+                hash_fn.reseed();
+                rebuild(bucket_count());
+                return;
+            }
+        }
+        rehash(bucket_count() * 3);
+    }
+
+    // Returns the slot holding `key` and whether its element is alive, or the empty
+    // slot `key` should be placed into.
+    std::pair<size_type, bool> locate(const key_type &key) {
         reserve(size() + 1);
         while (true) {
-            size_type ind = bucket(ptr->value.first);
+            size_type ind = bucket(key);
             probing.start();
             size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, ptr->value.first)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
+            for (size_type i = 0; i < probe_limit(); ++i) {
+                if (data.vacant(cur)) {
+                    return std::make_pair(cur, false);
                 }
-                data[cur] = std::move(ptr);
-                return;
+                if (equal_fn(data[cur]->value.first, key)) {
+                    return std::make_pair(cur, !data[cur]->is_deleted);
+                }
+                cur = (ind + probing.next()) % bucket_count();
             }
-            rehash(bucket_count() * 3);
+            grow();
+        }
+    }
+
+    // Puts a new element into a slot returned by `locate`.
+    void place(size_type cur, std::unique_ptr<Bucket> ptr) {
+        if (!data.vacant(cur)) {
+            --del_count;
         }
+        ++el_count;
+        ptr->generation = data.generation;
+        data[cur] = std::move(ptr);
+    }
+
+    std::pair<iterator, bool> emplace_ptr(std::unique_ptr<Bucket> ptr) {
+        auto slot = locate(ptr->value.first);
+        if (slot.second) {
+            return std::make_pair(iterator(&data, slot.first), false);
+        }
+        place(slot.first, std::move(ptr));
+        return std::make_pair(iterator(&data, slot.first), true);
     }
 
 public:
@@ -464,7 +502,7 @@ public:
 
     template<class P>
     iterator insert(const_iterator hint, P &&inserted_value) {
-        return emplace(hint, std::forward<P>(inserted_value));
+        return emplace_hint(hint, std::forward<P>(inserted_value));
     }
 
     template<class InputIt>
@@ -475,74 +513,36 @@ public:
     }
 
     void insert(std::initializer_list<value_type> init) {
-        for (auto it : init) {
-            insert(*it);
-        }
+        insert(init.begin(), init.end());
     }
 
     template<class M>
     std::pair<iterator, bool> insert_or_assign(const key_type &key, M &&inserted_value) {
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        data[cur]->value.second = mapped_type(std::forward<M>(inserted_value));
-                        return std::make_pair(iterator(&data, cur), false);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(key, std::forward<M>(inserted_value));
-                return std::make_pair(iterator(&data, cur), true);
-            }
-            rehash(bucket_count() * 3);
+        auto slot = locate(key);
+        if (slot.second) {
+            data[slot.first]->value.second = mapped_type(std::forward<M>(inserted_value));
+            return std::make_pair(iterator(&data, slot.first), false);
         }
+        place(slot.first, std::make_unique<Bucket>(key, std::forward<M>(inserted_value)));
+        return std::make_pair(iterator(&data, slot.first), true);
     }
 
     template<class M>
     std::pair<iterator, bool> insert_or_assign(key_type &&key, M &&inserted_value) {
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        data[cur]->value.second = mapped_type(std::forward<M>(inserted_value));
-                        return std::make_pair(iterator(&data, cur), false);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::move(key), std::forward<M>(inserted_value));
-                return std::make_pair(iterator(&data, cur), true);
-            }
-            rehash(bucket_count() * 3);
+        auto slot = locate(key);
+        if (slot.second) {
+            data[slot.first]->value.second = mapped_type(std::forward<M>(inserted_value));
+            return std::make_pair(iterator(&data, slot.first), false);
         }
+        place(slot.first, std::make_unique<Bucket>(std::move(key), std::forward<M>(inserted_value)));
+        return std::make_pair(iterator(&data, slot.first), true);
     }
 
     template<class M>
     iterator insert_or_assign(const_iterator hint, const key_type &key, M &&inserted_value) {
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->value.first, key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->value.first, key)) {
                 if (t->is_deleted) {
                     t->is_deleted = false;
                     --del_count;
@@ -552,38 +552,14 @@ public:
                 return hint;
             }
         }
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        data[cur]->value.second = mapped_type(std::forward<M>(inserted_value));
-                        return iterator(&data, cur);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(key, std::forward<M>(inserted_value));
-                return iterator(&data, cur);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return insert_or_assign(key, std::forward<M>(inserted_value)).first;
     }
 
     template<class M>
     iterator insert_or_assign(const_iterator hint, key_type &&key, M &&inserted_value) {
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->value.first, key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->value.first, key)) {
                 if (t->is_deleted) {
                     t->is_deleted = false;
                     --del_count;
@@ -593,60 +569,12 @@ public:
                 return hint;
             }
         }
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        data[cur]->value.second = mapped_type(std::forward<M>(inserted_value));
-                        return iterator(&data, cur);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::move(key), std::forward<M>(inserted_value));
-                return iterator(&data, cur);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return insert_or_assign(std::move(key), std::forward<M>(inserted_value)).first;
     }
 
     template<class... Args>
     std::pair<iterator, bool> emplace(Args &&... args) {
-        auto link = std::make_unique<Bucket>(std::forward<Args>(args)...);
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(link->value.first);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, link->value.first)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return std::make_pair(iterator(&data, cur), false);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::move(link);
-                return std::make_pair(iterator(&data, cur), true);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return emplace_ptr(std::make_unique<Bucket>(std::forward<Args>(args)...));
     }
 
     template<class... Args>
@@ -654,148 +582,65 @@ public:
         auto link = std::make_unique<Bucket>(std::forward<Args>(args)...);
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->value.first, link->value.first)) {
+            if (!data.vacant(hint.current) && equal_fn(t->value.first, link->value.first)) {
                 if (t->is_deleted) {
                     --del_count;
                     ++el_count;
+                    link->generation = data.generation;
                     data[hint.current] = std::move(link);
                 }
                 return hint;
             }
         }
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(link->value.first);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, link->value.first)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return iterator(&data, cur);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::move(link);
-                return iterator(&data, cur);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return emplace_ptr(std::move(link)).first;
     }
 
     template<class... Args>
     std::pair<iterator, bool> try_emplace(const key_type &key, Args &&... args) {
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return std::make_pair(iterator(&data, cur), false);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::piecewise_construct,
-                                                     std::forward_as_tuple(key),
-                                                     std::forward_as_tuple(std::forward<Args>(args)...));
-                return std::make_pair(iterator(&data, cur), true);
-            }
-            rehash(bucket_count() * 3);
+        auto slot = locate(key);
+        if (slot.second) {
+            return std::make_pair(iterator(&data, slot.first), false);
         }
+        place(slot.first, std::make_unique<Bucket>(std::piecewise_construct,
+                                                   std::forward_as_tuple(key),
+                                                   std::forward_as_tuple(std::forward<Args>(args)...)));
+        return std::make_pair(iterator(&data, slot.first), true);
     }
 
     template<class... Args>
     std::pair<iterator, bool> try_emplace(key_type &&key, Args &&... args) {
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return std::make_pair(iterator(&data, cur), false);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::piecewise_construct,
-                                                     std::forward_as_tuple(std::move(key)),
-                                                     std::forward_as_tuple(std::forward<Args>(args)...));
-                return std::make_pair(iterator(&data, cur), true);
-            }
-            rehash(bucket_count() * 3);
+        auto slot = locate(key);
+        if (slot.second) {
+            return std::make_pair(iterator(&data, slot.first), false);
         }
+        place(slot.first, std::make_unique<Bucket>(std::piecewise_construct,
+                                                   std::forward_as_tuple(std::move(key)),
+                                                   std::forward_as_tuple(std::forward<Args>(args)...)));
+        return std::make_pair(iterator(&data, slot.first), true);
     }
 
     template<class... Args>
     iterator try_emplace(const_iterator hint, const key_type &key, Args &&... args) {
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->value.first, key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->value.first, key)) {
                 if (t->is_deleted) {
                     t->is_deleted = false;
                     --del_count;
                     ++el_count;
-                    t->value.second = mapped_typ(std::forward<Args>(args)...);
+                    t->value.second = mapped_type(std::forward<Args>(args)...);
                 }
                 return hint;
             }
         }
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return iterator(&data, cur);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::piecewise_construct,
-                                                     std::forward_as_tuple(key),
-                                                     std::forward_as_tuple(std::forward<Args>(args)...));
-                return iterator(&data, cur);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return try_emplace(key, std::forward<Args>(args)...).first;
     }
 
     template<class... Args>
     iterator try_emplace(const_iterator hint, key_type &&key, Args &&... args) {
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->value.first, key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->value.first, key)) {
                 if (t->is_deleted) {
                     t->is_deleted = false;
                     --del_count;
@@ -805,32 +650,7 @@ public:
                 return hint;
             }
         }
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return iterator(&data, cur);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::piecewise_construct,
-                                                     std::forward_as_tuple(std::move(key)),
-                                                     std::forward_as_tuple(std::forward<Args>(args)...));
-                return iterator(&data, cur);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return try_emplace(std::move(key), std::forward<Args>(args)...).first;
     }
 
     iterator erase(const_iterator pos) {
@@ -857,9 +677,30 @@ public:
             erase(it);
             ++counter;
         }
+        shrink_if_sparse();
         return counter;
     }
 
+    // Visits up to `budget` slots starting at `cursor` and erases every element for
+    // which `pred(value)` holds; `cursor` is left after the last visited slot, so
+    // repeated calls sweep the whole table a few slots at a time.
+    template<class Pred>
+    size_type sweep(size_type &cursor, size_type budget, Pred pred) {
+        size_type erased = 0;
+        for (size_type i = 0; i < budget && bucket_count() != 0; ++i) {
+            cursor %= bucket_count();
+            Bucket *t = data[cursor].get();
+            if (!data.vacant(cursor) && !t->is_deleted && pred(t->value)) {
+                t->is_deleted = true;
+                ++del_count;
+                --el_count;
+                ++erased;
+            }
+            ++cursor;
+        }
+        return erased;
+    }
+
     [[nodiscard]] size_type count(const key_type &key) const {
         return contains(key) ? 1 : 0;
     }
@@ -870,7 +711,7 @@ public:
         probing_local.start();
         size_type cur = ind;
         for (size_type i = 0; i < bucket_count(); ++i) {
-            if (data[cur].get() == nullptr) {
+            if (data.vacant(cur)) {
                 return iterator();
             }
             if (equal_fn(data[cur]->value.first, key)) {
@@ -891,7 +732,7 @@ public:
         probing_local.start();
         size_type cur = ind;
         for (size_type i = 0; i < bucket_count(); ++i) {
-            if (data[cur].get() == nullptr) {
+            if (data.vacant(cur)) {
                 return const_iterator();
             }
             if (equal_fn(data[cur]->value.first, key)) {
@@ -910,6 +751,63 @@ public:
         return find(key) != cend();
     }
 
+private:
+    // Shared by both `find_many` overloads; `Self` is `const` for the const one.
+    template<class Self, class InputIt, class Callback>
+    static void probe_many(Self &self, InputIt first, InputIt last, Callback callback) {
+        interleaved_probe<CollisionPolicy>(self.data, first, last, [](const key_type &key) -> const key_type & {
+            return key;
+        }, [&self](const key_type &key) {
+            return self.bucket(key);
+        }, [&self](const Bucket &b, const key_type &key) {
+            return self.equal_fn(b.value.first, key);
+        }, [&self, &callback](const key_type &key, size_type slot, bool found) {
+            callback(key, found ? &self.data[slot]->value.second : nullptr);
+        });
+    }
+
+public:
+    // Looks up every key of [first, last) and calls `callback(key, value)` for it,
+    // where `value` points to the mapped value or is `nullptr`. The lookups run as
+    // interleaved state machines that yield to each other on every probe step (see
+    // `interleaved_probe`), so that their cache misses overlap; meant for bulk
+    // joins against tables much larger than the last level cache.
+    template<class InputIt, class Callback>
+    void find_many(InputIt first, InputIt last, Callback callback) {
+        probe_many(*this, first, last, callback);
+    }
+
+    template<class InputIt, class Callback>
+    void find_many(InputIt first, InputIt last, Callback callback) const {
+        probe_many(*this, first, last, callback);
+    }
+
+    // Inserts every pair of [first, last) whose key is absent, as `try_emplace`
+    // would, and calls `callback(pair, inserted)` for each. The lookups are
+    // interleaved as in `find_many`.
+    template<class InputIt, class Callback>
+    void insert_many(InputIt first, InputIt last, Callback callback) {
+        interleaved_probe<CollisionPolicy>(data, first, last, [](const auto &pair) -> const key_type & {
+            return pair.first;
+        }, [this](const key_type &key) {
+            return bucket(key);
+        }, [this](const Bucket &b, const key_type &key) {
+            return equal_fn(b.value.first, key);
+        }, [this, &callback](const auto &pair, size_type, bool found) {
+            callback(pair, !found && try_emplace(pair.first, pair.second).second);
+        });
+    }
+
+    // Returns the number of pairs that were inserted.
+    template<class InputIt>
+    size_type insert_many(InputIt first, InputIt last) {
+        size_type inserted = 0;
+        insert_many(first, last, [&inserted](const auto &, bool added) {
+            inserted += added;
+        });
+        return inserted;
+    }
+
     std::pair<iterator, iterator> equal_range(const key_type &key) {
         std::vector<size_type> order_list;
         for (auto it = begin(); it != end(); it++) {
@@ -940,63 +838,30 @@ public:
 
 
     mapped_type &operator[](const key_type &key) {
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return data[cur]->value.second;
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(key, mapped_type());
-                return data[cur]->value.second;
-            }
-            rehash(bucket_count() * 3);
-        }
+        return try_emplace(key).first->second;
     }
 
     mapped_type &operator[](key_type &&key) {
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->value.first, key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return data[cur]->value.second;
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::make_unique<Bucket>(std::piecewise_construct,
-                                                     std::forward_as_tuple(std::move(key)),
-                                                     std::forward_as_tuple());
-                return data[cur]->value.second;
-            }
-            rehash(bucket_count() * 3);
-        }
+        return try_emplace(std::move(key)).first->second;
     }
 
+    // Destroys every element but keeps the slot array.
     void clear() noexcept {
-        data.clear();
+        for (auto &ptr : data) {
+            ptr.reset();
+        }
+        el_count = 0;
+        del_count = 0;
+    }
+
+    // Empties the table in O(1) by moving to a new generation: the buckets stay in
+    // their slots but read as empty, and are destroyed when a slot is reused, the
+    // table is rebuilt or compacted, or on every 256th call, which clears fully.
+    // Meant for tables that are refilled over and over with similar contents.
+    void epoch_clear() noexcept {
+        if (++data.generation == 0) {
+            clear();
+        }
         el_count = 0;
         del_count = 0;
     }
@@ -1025,8 +890,17 @@ public:
         return max_bucket_count();
     }
 
+    [[nodiscard]] hasher hash_function() const {
+        return hash_fn;
+    }
+
+    [[nodiscard]] key_equal key_eq() const {
+        return equal_fn;
+    }
+
+    // A moved-from table has no buckets; every key then maps to the (absent) slot 0.
     [[nodiscard]] size_type bucket(const key_type &key) const {
-        return hash_fn(key) % bucket_count();
+        return bucket_count() == 0 ? 0 : apply_hash(hash_fn, key) % bucket_count();
     }
 
     [[nodiscard]] float load_factor() const {
@@ -1037,16 +911,84 @@ public:
         return 1;
     }
 
+private:
+    void rebuild(const size_type count) {
+        HashMap t = HashMap(count, hash_fn, equal_fn);
+        t.min_load = min_load;
+        for (auto it = begin(); it != end(); ++it) {
+            t.emplace_ptr(std::move(data[it.current]));
+        }
+        operator=(std::move(t));
+    }
+
+    void shrink_if_sparse() {
+        if (min_load > 0 && load_factor() < min_load) {
+            shrink_to_fit();
+        }
+    }
+
+public:
     void rehash(const size_type count) {
-        if (count > bucket_count() || del_count > size()) {
-            HashMap t = HashMap(std::max(bucket_count(), count), hash_fn, equal_fn);
-            for (auto it = begin(); it != end(); ++it) {
-                t.force_insert_ptr(std::move(data[it.current]));
+        if (count > bucket_count()) {
+            rebuild(count);
+        } else if (del_count > size()) {
+            compact();
+        }
+    }
+
+    // Drops all tombstones in place: deleted buckets are freed and live elements
+    // are moved back along their probe sequences into the freed slots until every
+    // element is reachable again. No second table is allocated.
+    void compact() {
+        for (auto &ptr : data) {
+            if (ptr.get() != nullptr && (ptr->is_deleted || ptr->generation != data.generation)) {
+                ptr.reset();
+            }
+        }
+        del_count = 0;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (size_type i = 0; i < bucket_count(); ++i) {
+                if (data[i].get() == nullptr) {
+                    continue;
+                }
+                CollisionPolicy probing_local{};
+                size_type ind = bucket(data[i]->value.first);
+                size_type cur = ind;
+                for (size_type j = 0; j < bucket_count() && cur != i; ++j) {
+                    if (data[cur].get() == nullptr) {
+                        data[cur] = std::move(data[i]);
+                        moved = true;
+                        break;
+                    }
+                    cur = (ind + probing_local.next()) % bucket_count();
+                }
             }
-            operator=(std::move(t));
         }
     }
 
+    // Gives memory back after the table has emptied out: rebuilds it at twice the
+    // element count, or only drops tombstones if it is already that small.
+    void shrink_to_fit() {
+        if (size() * 2 + 1 < bucket_count()) {
+            rebuild(size() * 2);
+        } else if (del_count > 0) {
+            compact();
+        }
+    }
+
+    // Erasing by key shrinks the table once its load factor falls below `factor`;
+    // 0 (the default) disables this. Values are capped at 0.25 so that a freshly
+    // shrunk table is never immediately shrunk again.
+    void set_min_load_factor(float factor) noexcept {
+        min_load = std::min(std::max(factor, 0.0f), 0.25f);
+    }
+
+    [[nodiscard]] float min_load_factor() const noexcept {
+        return min_load;
+    }
+
     void reserve(size_type count) {
         rehash(count);
     }
@@ -1070,4 +1012,8 @@ public:
     friend bool operator!=(const HashMap &first, const HashMap &second) {
         return !(first == second);
     }
-};
\ No newline at end of file
+};
+
+// Hash-flooding resistant map for attacker-controlled keys.
+template<class Key, class T, class CollisionPolicy = LinearProbing>
+using HardenedHashMap = HashMap<Key, T, CollisionPolicy, SipHash<Key>>;
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "hash_map.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// Map allowing several values per key. All values of a key are kept together in
+// one block, in insertion order, so `equal_range` is a single probe followed by a
+// contiguous scan. Iterators yield `(key, value)` pairs block by block.
+template<
+        class Key,
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class HashMultiMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using reference = std::pair<const Key &, T &>;
+    using const_reference = std::pair<const Key &, const T &>;
+
+private:
+    using block_map = HashMap<Key, std::vector<T>, CollisionPolicy, Hash, Equal>;
+
+    block_map blocks;
+    size_type el_count = 0;
+
+    static constexpr size_type past_block = static_cast<size_type>(-1);
+
+    template<class Outer, class Ref>
+    class Basic_Iterator {
+        friend class HashMultiMap;
+
+        template<class, class>
+        friend class Basic_Iterator;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef std::pair<const Key, T> value_type;
+        typedef Ref reference;
+
+        struct pointer {
+            Ref ref;
+
+            Ref *operator->() noexcept {
+                return &ref;
+            }
+        };
+
+    private:
+        Outer outer{};
+        size_type index{};
+        // Iterators returned by `equal_range` stay inside their block and end at
+        // index `past_block`, which stays the end of the range while its values are
+        // erased.
+        bool single_block{};
+
+        Basic_Iterator(Outer it, size_type ind, bool single) : outer(it), index(ind), single_block(single) {}
+
+    public:
+        Basic_Iterator() = default;
+
+        template<class OtherOuter, class OtherRef>
+        Basic_Iterator(const Basic_Iterator<OtherOuter, OtherRef> &other) : outer(other.outer), index(other.index),
+                                                                            single_block(other.single_block) {}
+
+        reference operator*() const {
+            return reference(outer->first, outer->second.at(index));
+        }
+
+        pointer operator->() const {
+            return pointer{operator*()};
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (outer != Outer() && index != past_block) {
+                ++index;
+                if (index == outer->second.size()) {
+                    if (single_block) {
+                        index = past_block;
+                    } else {
+                        ++outer;
+                        index = 0;
+                    }
+                }
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        template<class OtherOuter, class OtherRef>
+        bool operator==(const Basic_Iterator<OtherOuter, OtherRef> &other) const {
+            return outer == other.outer && index == other.index;
+        }
+
+        template<class OtherOuter, class OtherRef>
+        bool operator!=(const Basic_Iterator<OtherOuter, OtherRef> &other) const {
+            return !(*this == other);
+        }
+    };
+
+public:
+    using iterator = Basic_Iterator<typename block_map::iterator, reference>;
+    using const_iterator = Basic_Iterator<typename block_map::const_iterator, const_reference>;
+
+    explicit HashMultiMap(size_type expected_max_size = 0,
+                          const hasher &hash = hasher(),
+                          const key_equal &equal = key_equal()) : blocks(expected_max_size, hash, equal) {}
+
+    template<class InputIt>
+    HashMultiMap(InputIt first, InputIt last,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal()) : HashMultiMap(expected_max_size, hash, equal) {
+        insert(first, last);
+    }
+
+    HashMultiMap(std::initializer_list<value_type> init,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal()) : HashMultiMap(expected_max_size, hash, equal) {
+        insert(init);
+    }
+
+    HashMultiMap(const HashMultiMap &other) = default;
+
+    HashMultiMap(HashMultiMap &&other) noexcept : blocks(std::move(other.blocks)),
+                                                  el_count(std::exchange(other.el_count, 0)) {}
+
+    HashMultiMap &operator=(const HashMultiMap &other) {
+        if (this != &other) {
+            swap(HashMultiMap(other));
+        }
+        return *this;
+    }
+
+    HashMultiMap &operator=(HashMultiMap &&other) noexcept {
+        if (this != &other) {
+            swap(std::move(other));
+            other.clear();
+        }
+        return *this;
+    }
+
+    HashMultiMap &operator=(std::initializer_list<value_type> init) {
+        clear();
+        insert(init);
+        return *this;
+    }
+
+    void swap(HashMultiMap &&other) noexcept {
+        blocks.swap(std::move(other.blocks));
+        std::swap(el_count, other.el_count);
+    }
+
+    iterator begin() noexcept {
+        return iterator(blocks.begin(), 0, false);
+    }
+
+    const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return const_iterator(blocks.cbegin(), 0, false);
+    }
+
+    iterator end() noexcept {
+        return iterator();
+    }
+
+    const_iterator end() const noexcept {
+        return cend();
+    }
+
+    const_iterator cend() const noexcept {
+        return const_iterator();
+    }
+
+    // Appends a value to the block of `key`; equal keys never replace each other.
+    template<class... Args>
+    iterator emplace(const key_type &key, Args &&... args) {
+        auto block = blocks.try_emplace(key).first;
+        block->second.emplace_back(std::forward<Args>(args)...);
+        ++el_count;
+        return iterator(block, block->second.size() - 1, false);
+    }
+
+    iterator insert(const value_type &inserted_value) {
+        return emplace(inserted_value.first, inserted_value.second);
+    }
+
+    iterator insert(value_type &&inserted_value) {
+        return emplace(inserted_value.first, std::move(inserted_value.second));
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    // Removes one value; the values after it in its block keep their order.
+    iterator erase(const_iterator pos) {
+        auto block = static_cast<typename block_map::iterator>(pos.outer);
+        auto &values = block->second;
+        values.erase(values.begin() + pos.index);
+        --el_count;
+        if (values.empty()) {
+            // The erased block stays behind as a tombstone; release its storage now.
+            std::vector<T>().swap(values);
+        }
+        if (pos.index < values.size()) {
+            return iterator(block, pos.index, pos.single_block);
+        }
+        if (pos.single_block) {
+            if (values.empty()) {
+                blocks.erase(block);
+            }
+            return iterator(block, past_block, true);
+        }
+        return iterator(values.empty() ? blocks.erase(block) : ++block, 0, false);
+    }
+
+    // Removes the values in [first, last); a range covering a whole block, such
+    // as one from `equal_range`, drops the block in one step.
+    iterator erase(const_iterator first, const_iterator last) {
+        while (first != last) {
+            auto block = static_cast<typename block_map::iterator>(first.outer);
+            auto &values = block->second;
+            bool same = first.outer == last.outer;
+            size_type stop = same && last.index < values.size() ? last.index : values.size();
+            values.erase(values.begin() + first.index, values.begin() + stop);
+            el_count -= stop - first.index;
+            if (values.empty()) {
+                std::vector<T>().swap(values);
+            }
+            if (same) {
+                if (values.empty()) {
+                    blocks.erase(block);
+                }
+                return iterator(block, last.index == past_block ? past_block : first.index, last.single_block);
+            }
+            first = const_iterator(values.empty() ? blocks.erase(block) : ++block, 0, false);
+        }
+        return iterator(static_cast<typename block_map::iterator>(last.outer), last.index, last.single_block);
+    }
+
+    // Removes every value of `key` and returns how many there were.
+    size_type erase(const key_type &key) {
+        auto block = blocks.find(key);
+        if (block == blocks.end()) {
+            return 0;
+        }
+        size_type counter = block->second.size();
+        el_count -= counter;
+        std::vector<T>().swap(block->second);
+        blocks.erase(block);
+        return counter;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        auto block = blocks.find(key);
+        return block == blocks.cend() ? 0 : block->second.size();
+    }
+
+    [[nodiscard]] iterator find(const key_type &key) {
+        auto block = blocks.find(key);
+        return block == blocks.end() ? end() : iterator(block, 0, false);
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        auto block = blocks.find(key);
+        return block == blocks.cend() ? cend() : const_iterator(block, 0, false);
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return blocks.contains(key);
+    }
+
+    std::pair<iterator, iterator> equal_range(const key_type &key) {
+        auto block = blocks.find(key);
+        if (block == blocks.end()) {
+            return {end(), end()};
+        }
+        return {iterator(block, 0, true), iterator(block, past_block, true)};
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+        auto block = blocks.find(key);
+        if (block == blocks.cend()) {
+            return {cend(), cend()};
+        }
+        return {const_iterator(block, 0, true), const_iterator(block, past_block, true)};
+    }
+
+    void clear() noexcept {
+        blocks.clear();
+        el_count = 0;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Number of distinct keys.
+    [[nodiscard]] size_type key_count() const noexcept {
+        return blocks.size();
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return blocks.max_size();
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return blocks.bucket_count();
+    }
+
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return blocks.bucket(key);
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return blocks.load_factor();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return blocks.max_load_factor();
+    }
+
+    void rehash(const size_type count) {
+        blocks.rehash(count);
+    }
+
+    // Reserves room for `count` distinct keys.
+    void reserve(size_type count) {
+        blocks.reserve(count);
+    }
+
+    // Two multimaps are equal if every key has the same values, in any order.
+    friend bool operator==(const HashMultiMap &first, const HashMultiMap &second) {
+        if (first.size() != second.size() || first.key_count() != second.key_count()) {
+            return false;
+        }
+        for (auto it = first.blocks.cbegin(); it != first.blocks.cend(); ++it) {
+            auto other = second.blocks.find(it->first);
+            if (other == second.blocks.cend() ||
+                !std::is_permutation(it->second.begin(), it->second.end(),
+                                     other->second.begin(), other->second.end())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const HashMultiMap &first, const HashMultiMap &second) {
+        return !(first == second);
+    }
+};
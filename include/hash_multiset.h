@@ -0,0 +1,319 @@
+#pragma once
+
+#include "hash_map.h"
+#include <iterator>
+#include <stdexcept>
+
+// Set allowing equal keys. Each distinct key is stored once together with its
+// multiplicity, so `count` and `equal_range` are a single probe; iterators yield
+// every key as many times as it was inserted.
+template<
+        class Key,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class HashMultiSet {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using reference = const value_type &;
+    using const_reference = const value_type &;
+    using pointer = const value_type *;
+    using const_pointer = const value_type *;
+
+private:
+    using count_map = HashMap<Key, size_type, CollisionPolicy, Hash, Equal>;
+
+    count_map counts;
+    size_type el_count = 0;
+
+    static constexpr size_type past_key = static_cast<size_type>(-1);
+
+    class Basic_Iterator {
+        friend class HashMultiSet;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef const Key value_type;
+        typedef const Key *pointer;
+        typedef const Key &reference;
+
+    private:
+        typename count_map::const_iterator outer{};
+        size_type index{};
+        // Iterators returned by `equal_range` stay on their key and end at index
+        // `past_key`, which stays the end of the range while its copies are erased.
+        bool single_key{};
+
+        Basic_Iterator(typename count_map::const_iterator it, size_type ind, bool single) : outer(it), index(ind),
+                                                                                           single_key(single) {}
+
+    public:
+        Basic_Iterator() = default;
+
+        reference operator*() const {
+            return outer->first;
+        }
+
+        pointer operator->() const {
+            return &outer->first;
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (outer != typename count_map::const_iterator() && index != past_key) {
+                ++index;
+                if (index == outer->second) {
+                    if (single_key) {
+                        index = past_key;
+                    } else {
+                        ++outer;
+                        index = 0;
+                    }
+                }
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            return it1.outer == it2.outer && it1.index == it2.index;
+        }
+
+        friend bool operator!=(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            return !(it1 == it2);
+        }
+    };
+
+public:
+    using iterator = Basic_Iterator;
+    using const_iterator = Basic_Iterator;
+
+    explicit HashMultiSet(size_type expected_max_size = 0,
+                          const hasher &hash = hasher(),
+                          const key_equal &equal = key_equal()) : counts(expected_max_size, hash, equal) {}
+
+    template<class InputIt, class = typename std::iterator_traits<InputIt>::iterator_category>
+    HashMultiSet(InputIt first, InputIt last,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal()) : HashMultiSet(expected_max_size, hash, equal) {
+        insert(first, last);
+    }
+
+    HashMultiSet(std::initializer_list<value_type> init,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal()) : HashMultiSet(expected_max_size, hash, equal) {
+        insert(init);
+    }
+
+    HashMultiSet(const HashMultiSet &other) = default;
+
+    HashMultiSet(HashMultiSet &&other) noexcept : counts(std::move(other.counts)),
+                                                  el_count(std::exchange(other.el_count, 0)) {}
+
+    HashMultiSet &operator=(const HashMultiSet &other) {
+        if (this != &other) {
+            swap(HashMultiSet(other));
+        }
+        return *this;
+    }
+
+    HashMultiSet &operator=(HashMultiSet &&other) noexcept {
+        if (this != &other) {
+            swap(std::move(other));
+            other.clear();
+        }
+        return *this;
+    }
+
+    HashMultiSet &operator=(std::initializer_list<value_type> init) {
+        clear();
+        insert(init);
+        return *this;
+    }
+
+    void swap(HashMultiSet &&other) noexcept {
+        counts.swap(std::move(other.counts));
+        std::swap(el_count, other.el_count);
+    }
+
+    iterator begin() const noexcept {
+        return iterator(counts.cbegin(), 0, false);
+    }
+
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+
+    iterator end() const noexcept {
+        return iterator();
+    }
+
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    // Adds `copies` occurrences of `key` and returns an iterator to the first one.
+    iterator insert(const value_type &key, size_type copies = 1) {
+        if (copies == 0) {
+            return find(key);
+        }
+        auto it = counts.try_emplace(key, 0).first;
+        it->second += copies;
+        el_count += copies;
+        return iterator(it, 0, false);
+    }
+
+    // Only iterators select this overload, so `insert(key, copies)` with an
+    // integral key still reaches the counted insert.
+    template<class InputIt, class = typename std::iterator_traits<InputIt>::iterator_category>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    template<class... Args>
+    iterator emplace(Args &&... args) {
+        return insert(value_type(std::forward<Args>(args)...));
+    }
+
+    // Removes one occurrence of the key at `pos`.
+    iterator erase(const_iterator pos) {
+        auto it = static_cast<typename count_map::iterator>(pos.outer);
+        --el_count;
+        if (--it->second == 0) {
+            auto next = counts.erase(it);
+            return pos.single_key ? iterator(pos.outer, past_key, true) : iterator(next, 0, false);
+        }
+        if (pos.index < it->second) {
+            return pos;
+        }
+        return pos.single_key ? iterator(pos.outer, past_key, true) : iterator(++pos.outer, 0, false);
+    }
+
+    // Removes the keys in [first, last); a range covering every copy of a key,
+    // such as one from `equal_range`, drops the key in one step.
+    iterator erase(const_iterator first, const_iterator last) {
+        while (first != last) {
+            auto it = static_cast<typename count_map::iterator>(first.outer);
+            bool same = first.outer == last.outer;
+            size_type stop = same && last.index < it->second ? last.index : it->second;
+            el_count -= stop - first.index;
+            it->second -= stop - first.index;
+            if (same) {
+                if (it->second == 0) {
+                    counts.erase(it);
+                }
+                return iterator(first.outer, last.index == past_key ? past_key : first.index, last.single_key);
+            }
+            first = iterator(it->second == 0 ? counts.erase(it) : ++it, 0, false);
+        }
+        return last;
+    }
+
+    // Removes every occurrence of `key` and returns how many there were.
+    size_type erase(const key_type &key) {
+        auto it = counts.find(key);
+        if (it == counts.end()) {
+            return 0;
+        }
+        size_type counter = it->second;
+        el_count -= counter;
+        counts.erase(it);
+        return counter;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        auto it = counts.find(key);
+        return it == counts.cend() ? 0 : it->second;
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        auto it = counts.find(key);
+        return it == counts.cend() ? end() : iterator(it, 0, false);
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return counts.contains(key);
+    }
+
+    std::pair<const_iterator, const_iterator> equal_range(const key_type &key) const {
+        auto it = counts.find(key);
+        if (it == counts.cend()) {
+            return {end(), end()};
+        }
+        return {iterator(it, 0, true), iterator(it, past_key, true)};
+    }
+
+    void clear() noexcept {
+        counts.clear();
+        el_count = 0;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    // Number of distinct keys.
+    [[nodiscard]] size_type key_count() const noexcept {
+        return counts.size();
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return counts.max_size();
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return counts.bucket_count();
+    }
+
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return counts.bucket(key);
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return counts.load_factor();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return counts.max_load_factor();
+    }
+
+    void rehash(const size_type count) {
+        counts.rehash(count);
+    }
+
+    // Reserves room for `count` distinct keys.
+    void reserve(size_type count) {
+        counts.reserve(count);
+    }
+
+    friend bool operator==(const HashMultiSet &first, const HashMultiSet &second) {
+        return first.size() == second.size() && first.counts == second.counts;
+    }
+
+    friend bool operator!=(const HashMultiSet &first, const HashMultiSet &second) {
+        return !(first == second);
+    }
+};
@@ -1,8 +1,13 @@
 #pragma once
 
 #include <iostream>
+#include "hash_functions.h"
+#include "interleaved_probe.h"
 #include "policy.h"
+#include "prefetch.h"
+#include <cstdint>
 #include <memory>
+#include <utility>
 #include <vector>
 
 template<
@@ -30,6 +35,7 @@ private:
     struct Bucket {
         const Key key;
         bool is_deleted;
+        std::uint8_t generation = 0;
 
         explicit Bucket(const Key &k, bool b = false) : key(k), is_deleted(b) {}
 
@@ -39,12 +45,27 @@ private:
         explicit Bucket(Args &&... args) : key(std::forward<Args>(args)...), is_deleted(false) {}
     };
 
-    typedef typename std::vector<std::unique_ptr<Bucket>> container;
+    // The slot array, and the generation that live buckets are tagged with: a
+    // bucket from an older generation was dropped by `epoch_clear` and reads as
+    // an empty slot.
+    struct Slots : std::vector<std::unique_ptr<Bucket>> {
+        using std::vector<std::unique_ptr<Bucket>>::vector;
+
+        std::uint8_t generation = 0;
+
+        [[nodiscard]] bool vacant(size_type i) const noexcept {
+            const Bucket *b = (*this)[i].get();
+            return b == nullptr || b->generation != generation;
+        }
+    };
+
+    typedef Slots container;
     container data;
     size_type el_count;
     size_type del_count;
     hasher hash_fn;
     key_equal equal_fn;
+    float min_load = 0;
 
 
     class Basic_Iterator {
@@ -73,6 +94,8 @@ private:
                                                       starting_pos(other.starting_pos),
                                                       iterator_end(other.iterator_end), is_ordered(false) {}
 
+        Basic_Iterator &operator=(const Basic_Iterator &other) = default;
+
     private:
         explicit Basic_Iterator(const container *cont, size_type ind = 0) : values(cont), current(ind),
                                                                             starting_pos(ind),
@@ -80,7 +103,7 @@ private:
             if (current >= values->size()) {
                 iterator_end = true;
             } else {
-                while ((*values)[current].get() == nullptr || (*values)[current].get()->is_deleted) {
+                while (values->vacant(current) || (*values)[current]->is_deleted) {
                     current = (current + 1) % values->size();
                     if (current == starting_pos) {
                         iterator_end = true;
@@ -129,7 +152,7 @@ private:
                             iterator_end = true;
                             break;
                         }
-                    } while ((*values)[current].get() == nullptr || (*values)[current].get()->is_deleted);
+                    } while (values->vacant(current) || (*values)[current]->is_deleted);
                 }
             }
             return *this;
@@ -155,90 +178,61 @@ public:
     using iterator = const_iterator;
 
     HashSet(size_type expected_max_size = 0,
-                     const hasher &hash = hasher(),
-                     const key_equal &equal = key_equal()) : data(),
-                                                             el_count(0),
-                                                             del_count(0), hash_fn(hash), equal_fn(equal) {
-        for (size_type i = 0; i < expected_max_size + 1; ++i) {
-            data.push_back(nullptr);
-        }
-    }
+            const hasher &hash = hasher(),
+            const key_equal &equal = key_equal()) : data(expected_max_size + 1),
+                                                    el_count(0),
+                                                    del_count(0), hash_fn(hash), equal_fn(equal) {}
 
     template<class InputIt>
     HashSet(InputIt first, InputIt last,
             size_type expected_max_size = 0,
             const hasher &hash = hasher(),
-            const key_equal &equal = key_equal()) {
-        HashSet(expected_max_size, hash, equal);
+            const key_equal &equal = key_equal()) : HashSet(expected_max_size, hash, equal) {
         insert(first, last);
     }
 
-    HashSet(const HashSet &other) {;
-        hash_fn = other.hash_fn;
-        equal_fn = other.equal_fn;
-        el_count = other.el_count;
-        del_count = 0;
-        data.clear();
+    // Copies keep the slot layout of `other`, tombstones included, so no element
+    // has to be probed for again.
+    HashSet(const HashSet &other) : data(other.bucket_count()),
+                                    el_count(other.el_count), del_count(other.del_count),
+                                    hash_fn(other.hash_fn), equal_fn(other.equal_fn), min_load(other.min_load) {
+        data.generation = other.data.generation;
         for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (auto it = other.cbegin(); it != other.cend(); ++it) {
-            data[it.current] = std::make_unique<Bucket>(*it);
+            if (!other.data.vacant(i)) {
+                data[i] = std::make_unique<Bucket>(std::as_const(*other.data[i]));
+            }
         }
     }
 
-    HashSet(HashSet &&other) {
-        el_count = std::move(other.el_count);
-        del_count = 0;
-        hash_fn = std::move(other.hash_fn);
-        equal_fn = std::move(other.equal_fn);
-        data.clear();
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            if (other.data[i].get() != nullptr && !other.data[i]->is_deleted) {
-                data[i] = std::move(other.data[i]);
-            }
-        }
+    // Steals the table of `other`, which is left empty.
+    HashSet(HashSet &&other) noexcept : data(std::move(other.data)),
+                                        el_count(std::exchange(other.el_count, 0)),
+                                        del_count(std::exchange(other.del_count, 0)),
+                                        hash_fn(std::move(other.hash_fn)), equal_fn(std::move(other.equal_fn)),
+                                        min_load(other.min_load) {
+        other.data.clear();
     }
 
     HashSet(std::initializer_list<value_type> init,
             size_type expected_max_size = 0,
             const hasher &hash = hasher(),
-            const key_equal &equal = key_equal()) {
-        HashSet(expected_max_size, hash, equal);
+            const key_equal &equal = key_equal()) : HashSet(expected_max_size, hash, equal) {
         insert(init);
     }
 
     HashSet &operator=(const HashSet &other) {
-        hash_fn = other.hash_fn;
-        equal_fn = other.equal_fn;
-        el_count = other.el_count;
-        del_count = 0;
-        data.clear();
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (auto it = other.cbegin(); it != other.cend(); ++it) {
-            data[it.current] = std::make_unique<Bucket>(*it);
+        if (this != &other) {
+            swap(HashSet(other));
         }
         return *this;
     }
 
     HashSet &operator=(HashSet &&other) noexcept {
-        el_count = std::move(other.el_count);
-        del_count = 0;
-        hash_fn = std::move(other.hash_fn);
-        equal_fn = std::move(other.equal_fn);
-        data.clear();
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            data.push_back(nullptr);
-        }
-        for (size_type i = 0; i < other.bucket_count(); ++i) {
-            if (other.data[i].get() != nullptr && !other.data[i]->is_deleted) {
-                data[i] = std::move(other.data[i]);
-            }
+        if (this != &other) {
+            swap(std::move(other));
+            other.data.clear();
+            other.el_count = 0;
+            other.del_count = 0;
         }
         return *this;
     }
@@ -255,6 +249,7 @@ public:
         std::swap(hash_fn, other.hash_fn);
         std::swap(el_count, other.el_count);
         std::swap(del_count, other.del_count);
+        std::swap(min_load, other.min_load);
     }
 
     [[nodiscard]] const_iterator begin() const noexcept {
@@ -274,90 +269,96 @@ public:
     }
 
 private:
-    void insert(std::unique_ptr<Bucket> ptr) {
+    // Longest probe sequence an insertion walks before the table is grown; keyed
+    // hashers get a logarithmic bound so that flooding is detected early.
+    [[nodiscard]] size_type probe_limit() const noexcept {
+        if constexpr (is_reseedable<hasher>::value) {
+            size_type limit = 16;
+            for (size_type n = bucket_count(); n > 1; n >>= 1) {
+                limit += 4;
+            }
+            return std::min(limit, bucket_count() / 2 + 1);
+        }
+        return bucket_count() / 2;
+    }
+
+    // Called when an insertion runs out of probes. A long probe sequence in a
+    // sparse table means colliding keys, so a keyed hasher is re-seeded instead
+    // of tripling the table.
+    void grow() {
+        if constexpr (is_reseedable<hasher>::value) {
+            if (size() < bucket_count() / 2) {
+                hash_fn.reseed();
+                rebuild(bucket_count());
+                return;
+            }
+        }
+        rehash(bucket_count() * 3);
+    }
+
+    // Returns the slot holding `key` and whether its element is alive, or the empty
+    // slot `key` should be placed into.
+    std::pair<size_type, bool> locate(const key_type &key) {
         reserve(size() + 1);
-        size_type ind = bucket(ptr.get()->key);
-        probing.start();
-        size_type cur = ind;
-        for (size_type i = 0; i < bucket_count() / 2; ++i) {
-            if (data[cur].get() == nullptr) {
-                data[cur] = std::move(ptr);
-                ++el_count;
-            } else if (equal_fn(data[cur]->key, ptr.get()->key)) {
-                if (data[cur]->is_deleted) {
-                    data[cur]->is_deleted = false;
-                    --del_count;
-                    ++el_count;
+        while (true) {
+            size_type ind = bucket(key);
+            probing.start();
+            size_type cur = ind;
+            for (size_type i = 0; i < probe_limit(); ++i) {
+                if (data.vacant(cur)) {
+                    return std::make_pair(cur, false);
+                }
+                if (equal_fn(data[cur]->key, key)) {
+                    return std::make_pair(cur, !data[cur]->is_deleted);
                 }
-            } else {
                 cur = (ind + probing.next()) % bucket_count();
-                continue;
             }
-            return;
+            grow();
         }
-        rehash(bucket_count() * 3);
-        insert(std::move(ptr));
+    }
+
+    // Puts a new element into a slot returned by `locate`.
+    void place(size_type cur, std::unique_ptr<Bucket> ptr) {
+        if (!data.vacant(cur)) {
+            --del_count;
+        }
+        ++el_count;
+        ptr->generation = data.generation;
+        data[cur] = std::move(ptr);
+    }
+
+    std::pair<iterator, bool> emplace_ptr(std::unique_ptr<Bucket> ptr) {
+        auto slot = locate(ptr->key);
+        if (slot.second) {
+            return std::make_pair(Basic_Iterator(&data, slot.first), false);
+        }
+        place(slot.first, std::move(ptr));
+        return std::make_pair(Basic_Iterator(&data, slot.first), true);
     }
 
 public:
     std::pair<iterator, bool> insert(const value_type &inserted_value) {
-        reserve(size() + 1);
-        size_type ind = bucket(inserted_value);
-        probing.start();
-        size_type cur = ind;
-        for (size_type i = 0; i < bucket_count() / 2; ++i) {
-            if (data[cur].get() == nullptr) {
-                data[cur] = std::make_unique<Bucket>(inserted_value, false);
-                ++el_count;
-                return std::make_pair(Basic_Iterator(&data, cur), true);
-            }
-            if (equal_fn(data[cur]->key, inserted_value)) {
-                if (data[cur]->is_deleted) {
-                    data[cur]->is_deleted = false;
-                    --del_count;
-                    ++el_count;
-                    return std::make_pair(Basic_Iterator(&data, cur), true);
-                } else {
-                    return std::make_pair(Basic_Iterator(&data, cur), false);
-                }
-            }
-            cur = (ind + probing.next()) % bucket_count();
+        auto slot = locate(inserted_value);
+        if (slot.second) {
+            return std::make_pair(Basic_Iterator(&data, slot.first), false);
         }
-        rehash(bucket_count() * 3);
-        return insert(inserted_value);
+        place(slot.first, std::make_unique<Bucket>(inserted_value, false));
+        return std::make_pair(Basic_Iterator(&data, slot.first), true);
     }
 
     std::pair<iterator, bool> insert(value_type &&key) {
-        reserve(size() + 1);
-        size_type ind = bucket(key);
-        probing.start();
-        size_type cur = ind;
-        for (size_type i = 0; i < bucket_count() / 2; ++i) {
-            if (data[cur].get() == nullptr) {
-                data[cur] = std::make_unique<Bucket>(std::move(key), false);
-                ++el_count;
-                return std::make_pair(Basic_Iterator(&data, cur), true);
-            }
-            if (equal_fn(data[cur]->key, key)) {
-                if (data[cur]->is_deleted) {
-                    data[cur]->is_deleted = false;
-                    --del_count;
-                    ++el_count;
-                    return std::make_pair(Basic_Iterator(&data, cur), true);
-                } else {
-                    return std::make_pair(Basic_Iterator(&data, cur), false);
-                }
-            }
-            cur = (ind + probing.next()) % bucket_count();
+        auto slot = locate(key);
+        if (slot.second) {
+            return std::make_pair(Basic_Iterator(&data, slot.first), false);
         }
-        rehash(bucket_count() * 3);
-        return insert(std::move(key));
+        place(slot.first, std::make_unique<Bucket>(std::move(key), false));
+        return std::make_pair(Basic_Iterator(&data, slot.first), true);
     }
 
     iterator insert(const_iterator hint, const value_type &key) {
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->key, key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->key, key)) {
                 if (t->is_deleted) {
                     t->is_deleted = false;
                     --del_count;
@@ -372,7 +373,7 @@ public:
     iterator insert(const_iterator hint, value_type &&key) {
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->key, key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->key, key)) {
                 if (t->is_deleted) {
                     t->is_deleted = false;
                     --del_count;
@@ -392,38 +393,12 @@ public:
     }
 
     void insert(std::initializer_list<value_type> init) {
-        for (auto it : init) {
-            insert(*it);
-        }
+        insert(init.begin(), init.end());
     }
 
     template<class... Args>
     std::pair<iterator, bool> emplace(Args &&... args) {
-        auto link = std::make_unique<Bucket>(std::forward<Args>(args)...);
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(link->key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->key, link->key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return std::make_pair(iterator(&data, cur), false);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::move(link);
-                return std::make_pair(iterator(&data, cur), true);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return emplace_ptr(std::make_unique<Bucket>(std::forward<Args>(args)...));
     }
 
     template<class... Args>
@@ -431,39 +406,17 @@ public:
         auto link = std::make_unique<Bucket>(std::forward<Args>(args)...);
         if (hint != cend()) {
             auto t = data[hint.current].get();
-            if (t != nullptr && equal_fn(t->key, link->key)) {
+            if (!data.vacant(hint.current) && equal_fn(t->key, link->key)) {
                 if (t->is_deleted) {
                     --del_count;
                     ++el_count;
+                    link->generation = data.generation;
                     data[hint.current] = std::move(link);
                 }
                 return hint;
             }
         }
-        reserve(size() + 1);
-        while (true) {
-            size_type ind = bucket(link->key);
-            probing.start();
-            size_type cur = ind;
-            for (size_type i = 0; i < bucket_count() / 2; ++i) {
-                if (data[cur].get() == nullptr) {
-                    ++el_count;
-                } else if (equal_fn(data[cur]->key, link->key)) {
-                    if (data[cur]->is_deleted) {
-                        --del_count;
-                        ++el_count;
-                    } else {
-                        return iterator(&data, cur);
-                    }
-                } else {
-                    cur = (ind + probing.next()) % bucket_count();
-                    continue;
-                }
-                data[cur] = std::move(link);
-                return iterator(&data, cur);
-            }
-            rehash(bucket_count() * 3);
-        }
+        return emplace_ptr(std::move(link)).first;
     }
 
     iterator erase(const_iterator pos) {
@@ -490,6 +443,7 @@ public:
             erase(it);
             ++counter;
         }
+        shrink_if_sparse();
         return counter;
     }
 
@@ -497,25 +451,104 @@ public:
         return contains(key) ? 1 : 0;
     }
 
-    [[nodiscard]] const_iterator find(const key_type &key) const {
+private:
+    // Probes for `key` starting from its home slot `ind`; returns `bucket_count()`
+    // if the key is absent.
+    [[nodiscard]] size_type find_slot(const key_type &key, size_type ind) const {
         CollisionPolicy probing_local{};
-        size_type ind = bucket(key);
         probing_local.start();
         size_type cur = ind;
         for (size_type i = 0; i < bucket_count(); ++i) {
-            if (data[cur].get() == nullptr) {
-                return cend();
+            if (data.vacant(cur)) {
+                return bucket_count();
             }
             if (equal_fn(data[cur]->key, key)) {
-                if (data[cur]->is_deleted) {
-                    return cend();
-                } else {
-                    return Basic_Iterator(&data, cur);
-                }
+                return data[cur]->is_deleted ? bucket_count() : cur;
             }
             cur = (ind + probing_local.next()) % bucket_count();
         }
-        return cend();
+        return bucket_count();
+    }
+
+    static constexpr size_type batch_size = 16;
+
+public:
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        size_type cur = find_slot(key, bucket(key));
+        return cur == bucket_count() ? cend() : Basic_Iterator(&data, cur);
+    }
+
+    // Looks up every key of [first, last) and calls `callback(key, found)` for it.
+    // Keys are processed in batches whose home slots and buckets are prefetched
+    // before the first comparison, so the cache misses of a batch overlap.
+    // The iterators must yield references that stay valid during the call.
+    template<class InputIt, class Callback>
+    void find_batch(InputIt first, InputIt last, Callback callback) const {
+        const key_type *keys[batch_size];
+        size_type homes[batch_size];
+        if (bucket_count() == 0) {
+            for (; first != last; ++first) {
+                callback(*first, false);
+            }
+            return;
+        }
+        while (first != last) {
+            size_type n = 0;
+            for (; n < batch_size && first != last; ++n, ++first) {
+                keys[n] = &*first;
+                homes[n] = bucket(*keys[n]);
+                prefetch(&data[homes[n]]);
+            }
+            for (size_type i = 0; i < n; ++i) {
+                prefetch(data[homes[i]].get());
+            }
+            for (size_type i = 0; i < n; ++i) {
+                callback(*keys[i], find_slot(*keys[i], homes[i]) != bucket_count());
+            }
+        }
+    }
+
+    // Like `find_batch`, but runs the lookups as interleaved state machines that
+    // yield to each other on every probe step (see `interleaved_probe`), so long
+    // probe sequences overlap as well as the first miss. Meant for tables much
+    // larger than the last level cache.
+    template<class InputIt, class Callback>
+    void find_many(InputIt first, InputIt last, Callback callback) const {
+        interleaved_probe<CollisionPolicy>(data, first, last, [](const key_type &key) -> const key_type & {
+            return key;
+        }, [this](const key_type &key) {
+            return bucket(key);
+        }, [this](const Bucket &b, const key_type &key) {
+            return equal_fn(b.key, key);
+        }, [&callback](const key_type &key, size_type, bool found) {
+            callback(key, found);
+        });
+    }
+
+    // Inserts every key of [first, last), calling `callback(key, inserted)` for
+    // each. The lookups are interleaved as in `find_many`; a key found absent is
+    // then inserted while its probe sequence is still cached.
+    template<class InputIt, class Callback>
+    void insert_many(InputIt first, InputIt last, Callback callback) {
+        interleaved_probe<CollisionPolicy>(data, first, last, [](const key_type &key) -> const key_type & {
+            return key;
+        }, [this](const key_type &key) {
+            return bucket(key);
+        }, [this](const Bucket &b, const key_type &key) {
+            return equal_fn(b.key, key);
+        }, [this, &callback](const key_type &key, size_type, bool found) {
+            callback(key, !found && insert(key).second);
+        });
+    }
+
+    // Returns the number of keys that were not present before.
+    template<class InputIt>
+    size_type insert_many(InputIt first, InputIt last) {
+        size_type inserted = 0;
+        insert_many(first, last, [&inserted](const key_type &, bool added) {
+            inserted += added;
+        });
+        return inserted;
     }
 
     [[nodiscard]] bool contains(const key_type &key) const {
@@ -532,8 +565,23 @@ public:
         return {Basic_Iterator(&data, std::move(order_list)), Basic_Iterator()};
     }
 
+    // Destroys every element but keeps the slot array.
     void clear() noexcept {
-        data.clear();
+        for (auto &ptr : data) {
+            ptr.reset();
+        }
+        el_count = 0;
+        del_count = 0;
+    }
+
+    // Empties the table in O(1) by moving to a new generation: the buckets stay in
+    // their slots but read as empty, and are destroyed when a slot is reused, the
+    // table is rebuilt or compacted, or on every 256th call, which clears fully.
+    // Meant for tables that are refilled over and over with similar contents.
+    void epoch_clear() noexcept {
+        if (++data.generation == 0) {
+            clear();
+        }
         el_count = 0;
         del_count = 0;
     }
@@ -562,8 +610,17 @@ public:
         return max_bucket_count();
     }
 
+    [[nodiscard]] hasher hash_function() const {
+        return hash_fn;
+    }
+
+    [[nodiscard]] key_equal key_eq() const {
+        return equal_fn;
+    }
+
+    // A moved-from table has no buckets; every key then maps to the (absent) slot 0.
     [[nodiscard]] size_type bucket(const key_type &key) const {
-        return hash_fn(key) % bucket_count();
+        return bucket_count() == 0 ? 0 : apply_hash(hash_fn, key) % bucket_count();
     }
 
     [[nodiscard]] float load_factor() const {
@@ -574,35 +631,191 @@ public:
         return 1;
     }
 
+private:
+    void rebuild(const size_type count) {
+        HashSet t = HashSet(count, hash_fn, equal_fn);
+        t.min_load = min_load;
+        for (auto it = begin(); it != end(); ++it) {
+            t.emplace_ptr(std::move(data[it.current]));
+        }
+        operator=(std::move(t));
+    }
+
+    void shrink_if_sparse() {
+        if (min_load > 0 && load_factor() < min_load) {
+            shrink_to_fit();
+        }
+    }
+
+public:
     void rehash(const size_type count) {
-        if (count > bucket_count() || del_count > size()) {
-            HashSet t = HashSet(std::max(bucket_count(), count), hash_fn, equal_fn);
-            for (auto it = begin(); it != end(); ++it) {
-                t.insert(std::move(data[it.current]));
+        if (count > bucket_count()) {
+            rebuild(count);
+        } else if (del_count > size()) {
+            compact();
+        }
+    }
+
+    // Drops all tombstones in place: deleted buckets are freed and live elements
+    // are moved back along their probe sequences into the freed slots until every
+    // element is reachable again. No second table is allocated.
+    void compact() {
+        for (auto &ptr : data) {
+            if (ptr.get() != nullptr && (ptr->is_deleted || ptr->generation != data.generation)) {
+                ptr.reset();
+            }
+        }
+        del_count = 0;
+        bool moved = true;
+        while (moved) {
+            moved = false;
+            for (size_type i = 0; i < bucket_count(); ++i) {
+                if (data[i].get() == nullptr) {
+                    continue;
+                }
+                CollisionPolicy probing_local{};
+                size_type ind = bucket(data[i]->key);
+                size_type cur = ind;
+                for (size_type j = 0; j < bucket_count() && cur != i; ++j) {
+                    if (data[cur].get() == nullptr) {
+                        data[cur] = std::move(data[i]);
+                        moved = true;
+                        break;
+                    }
+                    cur = (ind + probing_local.next()) % bucket_count();
+                }
             }
-            operator=(std::move(t));
         }
     }
 
+    // Gives memory back after the table has emptied out: rebuilds it at twice the
+    // element count, or only drops tombstones if it is already that small.
+    void shrink_to_fit() {
+        if (size() * 2 + 1 < bucket_count()) {
+            rebuild(size() * 2);
+        } else if (del_count > 0) {
+            compact();
+        }
+    }
+
+    // Erasing by key shrinks the table once its load factor falls below `factor`;
+    // 0 (the default) disables this. Values are capped at 0.25 so that a freshly
+    // shrunk table is never immediately shrunk again.
+    void set_min_load_factor(float factor) noexcept {
+        min_load = std::min(std::max(factor, 0.0f), 0.25f);
+    }
+
+    [[nodiscard]] float min_load_factor() const noexcept {
+        return min_load;
+    }
+
     void reserve(size_type count) {
         rehash(count);
     }
 
-    friend bool operator==(const HashSet &first, const HashSet &second) {
-        for (auto it = first.begin(); it != first.end(); it++) {
-            if (!second.contains(*it)) {
-                return false;
+    [[nodiscard]] bool is_subset_of(const HashSet &other) const {
+        if (size() > other.size()) {
+            return false;
+        }
+        bool subset = true;
+        other.find_batch(begin(), end(), [&subset](const key_type &, bool found) {
+            subset = subset && found;
+        });
+        return subset;
+    }
+
+    // Keeps only the elements that are also in `other`.
+    void intersect_with(const HashSet &other) {
+        if (other.size() < size()) {
+            HashSet t = HashSet(other.size(), hash_fn, equal_fn);
+            t.min_load = min_load;
+            find_batch(other.begin(), other.end(), [&t](const key_type &key, bool found) {
+                if (found) {
+                    t.insert(key);
+                }
+            });
+            swap(std::move(t));
+            return;
+        }
+        std::vector<key_type> missing;
+        other.find_batch(begin(), end(), [&missing](const key_type &key, bool found) {
+            if (!found) {
+                missing.push_back(key);
+            }
+        });
+        for (auto &key : missing) {
+            erase(key);
+        }
+    }
+
+    void unite_with(const HashSet &other) {
+        reserve(size() + other.size());
+        insert(other.begin(), other.end());
+    }
+
+    // Removes the elements that are in `other`.
+    void subtract(const HashSet &other) {
+        if (other.size() < size()) {
+            for (auto it = other.begin(); it != other.end(); ++it) {
+                erase(*it);
+            }
+            return;
+        }
+        std::vector<key_type> common;
+        other.find_batch(begin(), end(), [&common](const key_type &key, bool found) {
+            if (found) {
+                common.push_back(key);
             }
+        });
+        for (auto &key : common) {
+            erase(key);
         }
-        for (auto it = second.begin(); it != second.end(); it++) {
-            if (!first.contains(*it)) {
-                return false;
+    }
+
+    friend HashSet set_union(const HashSet &first, const HashSet &second) {
+        const HashSet &larger = first.size() < second.size() ? second : first;
+        const HashSet &smaller = first.size() < second.size() ? first : second;
+        HashSet result = larger;
+        result.unite_with(smaller);
+        return result;
+    }
+
+    friend HashSet set_intersection(const HashSet &first, const HashSet &second) {
+        const HashSet &larger = first.size() < second.size() ? second : first;
+        const HashSet &smaller = first.size() < second.size() ? first : second;
+        HashSet result = HashSet(smaller.size(), first.hash_fn, first.equal_fn);
+        larger.find_batch(smaller.begin(), smaller.end(), [&result](const key_type &key, bool found) {
+            if (found) {
+                result.insert(key);
             }
+        });
+        return result;
+    }
+
+    friend HashSet set_difference(const HashSet &first, const HashSet &second) {
+        if (second.size() < first.size()) {
+            HashSet result = first;
+            result.subtract(second);
+            return result;
         }
-        return true;
+        HashSet result = HashSet(first.size(), first.hash_fn, first.equal_fn);
+        second.find_batch(first.begin(), first.end(), [&result](const key_type &key, bool found) {
+            if (!found) {
+                result.insert(key);
+            }
+        });
+        return result;
+    }
+
+    friend bool operator==(const HashSet &first, const HashSet &second) {
+        return first.size() == second.size() && first.is_subset_of(second);
     }
 
     friend bool operator!=(const HashSet &first, const HashSet &second) {
         return !(first == second);
     }
 };
+
+// Hash-flooding resistant set for attacker-controlled keys.
+template<class Key, class CollisionPolicy = LinearProbing>
+using HardenedHashSet = HashSet<Key, CollisionPolicy, SipHash<Key>>;
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Page sizes a HugePageAllocator can ask for.
+enum class PageSize {
+    Regular,
+    Huge2M,
+    Huge1G,
+};
+
+// What actually backs an allocation, from best to worst: explicit huge pages
+// need pages reserved by the administrator (vm.nr_hugepages); transparent huge
+// pages are a kernel hint that may or may not be honoured.
+enum class PageBacking {
+    Huge1G,
+    Huge2M,
+    TransparentHuge,
+    Regular,
+    Heap,
+};
+
+enum class NumaPolicy {
+    Default,
+    Interleave,
+    Bind,
+};
+
+struct MemoryOptions {
+    PageSize pages = PageSize::Huge2M;
+    NumaPolicy numa = NumaPolicy::Default;
+    // Bit i selects NUMA node i for `Interleave` and `Bind`.
+    unsigned long node_mask = 0;
+    // Smaller allocations come from the regular heap.
+    std::size_t min_mapped_bytes = 1 << 20;
+};
+
+// What the most recent allocation of an allocator (and of its copies) got.
+struct MemoryReport {
+    PageBacking backing = PageBacking::Heap;
+    bool numa_applied = false;
+    std::size_t mapped_bytes = 0;
+};
+
+// Allocator for large slot arrays that backs them with huge pages, so that a
+// random access into a table of many gigabytes needs far fewer TLB entries. It
+// tries an explicit MAP_HUGETLB mapping of the requested page size, then a
+// regular mapping with MADV_HUGEPAGE, then plain pages, and can interleave the
+// memory over NUMA nodes or bind it to some. Every fallback is silent; `report`
+// tells which backing was used. Off Linux it is `std::allocator`.
+template<class T>
+class HugePageAllocator {
+    template<class>
+    friend class HugePageAllocator;
+
+public:
+    using value_type = T;
+
+    // Copies and rebinds of an allocator must free each other's memory, so they
+    // carry the same options; the report is shared between them.
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+private:
+    MemoryOptions options;
+    std::shared_ptr<MemoryReport> last;
+
+    [[nodiscard]] std::size_t page_bytes() const noexcept {
+        switch (options.pages) {
+            case PageSize::Huge1G:
+                return std::size_t(1) << 30;
+            case PageSize::Huge2M:
+                return std::size_t(1) << 21;
+            default:
+                return std::size_t(1) << 12;
+        }
+    }
+
+    // Every mapping of `bytes` has this length, whichever backing it got, so
+    // that `deallocate` can unmap it without remembering how it was made.
+    [[nodiscard]] std::size_t mapped_length(std::size_t bytes) const noexcept {
+        return (bytes + page_bytes() - 1) / page_bytes() * page_bytes();
+    }
+
+    [[nodiscard]] bool use_heap(std::size_t bytes) const noexcept {
+#if defined(__linux__)
+        return bytes < options.min_mapped_bytes;
+#else
+        (void) bytes;
+        return true;
+#endif
+    }
+
+#if defined(__linux__)
+    void *map(std::size_t length, PageBacking &backing) const noexcept {
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_HUGETLB)
+        if (options.pages != PageSize::Regular) {
+            int shift = options.pages == PageSize::Huge1G ? 30 : 21;
+            void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB | (shift << 26), -1, 0);
+            if (ptr != MAP_FAILED) {
+                backing = options.pages == PageSize::Huge1G ? PageBacking::Huge1G : PageBacking::Huge2M;
+                return ptr;
+            }
+        }
+#endif
+        void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (ptr == MAP_FAILED) {
+            return nullptr;
+        }
+        backing = PageBacking::Regular;
+#if defined(MADV_HUGEPAGE)
+        if (options.pages != PageSize::Regular && madvise(ptr, length, MADV_HUGEPAGE) == 0) {
+            backing = PageBacking::TransparentHuge;
+        }
+#endif
+        return ptr;
+    }
+
+    // Applies the NUMA policy with the raw system call, so that libnuma is not
+    // needed; without kernel support this is a no-op.
+    bool bind(void *ptr, std::size_t length) const noexcept {
+#if defined(SYS_mbind)
+        if (options.numa == NumaPolicy::Default || options.node_mask == 0) {
+            return false;
+        }
+        const int mode = options.numa == NumaPolicy::Interleave ? 3 : 2;  // MPOL_INTERLEAVE, MPOL_BIND
+        unsigned long mask = options.node_mask;
+        return syscall(SYS_mbind, ptr, length, mode, &mask, sizeof(mask) * 8, 0) == 0;
+#else
+        (void) ptr;
+        (void) length;
+        return false;
+#endif
+    }
+#endif
+
+public:
+    explicit HugePageAllocator(const MemoryOptions &opts = MemoryOptions()) : options(opts),
+                                                                               last(std::make_shared<MemoryReport>()) {}
+
+    template<class U>
+    HugePageAllocator(const HugePageAllocator<U> &other) noexcept : options(other.options), last(other.last) {}
+
+    T *allocate(std::size_t n) {
+        std::size_t bytes = n * sizeof(T);
+        if (use_heap(bytes)) {
+            *last = MemoryReport{PageBacking::Heap, false, 0};
+            return std::allocator<T>().allocate(n);
+        }
+#if defined(__linux__)
+        std::size_t length = mapped_length(bytes);
+        PageBacking backing;
+        void *ptr = map(length, backing);
+        if (ptr == nullptr) {
+            throw std::bad_alloc();
+        }
+        bool numa = bind(ptr, length);
+        *last = MemoryReport{backing, numa, length};
+        return static_cast<T *>(ptr);
+#else
+        return nullptr;
+#endif
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        std::size_t bytes = n * sizeof(T);
+        if (use_heap(bytes)) {
+            std::allocator<T>().deallocate(ptr, n);
+            return;
+        }
+#if defined(__linux__)
+        munmap(ptr, mapped_length(bytes));
+#endif
+    }
+
+    [[nodiscard]] const MemoryReport &report() const noexcept {
+        return *last;
+    }
+
+    [[nodiscard]] const MemoryOptions &memory_options() const noexcept {
+        return options;
+    }
+
+    template<class U>
+    friend bool operator==(const HugePageAllocator &a, const HugePageAllocator<U> &b) noexcept {
+        return a.options.pages == b.options.pages && a.options.min_mapped_bytes == b.options.min_mapped_bytes;
+    }
+
+    template<class U>
+    friend bool operator!=(const HugePageAllocator &a, const HugePageAllocator<U> &b) noexcept {
+        return !(a == b);
+    }
+};
+
+inline const char *to_string(PageBacking backing) noexcept {
+    switch (backing) {
+        case PageBacking::Huge1G:
+            return "1GB huge pages";
+        case PageBacking::Huge2M:
+            return "2MB huge pages";
+        case PageBacking::TransparentHuge:
+            return "transparent huge pages";
+        case PageBacking::Regular:
+            return "regular pages";
+        default:
+            return "heap";
+    }
+}
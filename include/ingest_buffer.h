@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// What IngestBuffer stages for a table: the key for sets, and a key and value
+// pair with a mutable key for maps.
+template<class Table, class = void>
+struct ingest_value {
+    using type = typename Table::key_type;
+};
+
+template<class Table>
+struct ingest_value<Table, std::void_t<typename Table::mapped_type>> {
+    using type = std::pair<typename Table::key_type, typename Table::mapped_type>;
+};
+
+// Write-combining front end for a single thread that inserts at a high rate into
+// a HashSet or HashMap much larger than the cache. Elements are staged in a
+// buffer; `flush` reserves room for all of them at once, sorts them by the
+// region of the slot array their home slot falls into (a stable counting sort),
+// and inserts them region by region, so that consecutive insertions touch slots
+// that are already cached instead of one random line each. Staged elements are
+// invisible in the table until the next `flush`, which happens automatically
+// when the buffer is full and on destruction. Like `try_emplace`, an element
+// whose key is already present (or staged earlier) is dropped.
+template<class Table>
+class IngestBuffer {
+public:
+    using table_type = Table;
+    using key_type = typename Table::key_type;
+    using size_type = typename Table::size_type;
+
+    using value_type = typename ingest_value<Table>::type;
+
+    static constexpr bool is_map = !std::is_same_v<value_type, key_type>;
+
+    static constexpr size_type default_capacity = size_type(1) << 16;
+
+    // Slots per region: 4096 slot pointers take 32 KiB, which stays in L1/L2
+    // while the elements of one region are inserted.
+    static constexpr unsigned region_bits = 12;
+
+private:
+    Table &target;
+    std::vector<value_type> staged;
+    std::vector<std::uint32_t> regions;
+    std::vector<std::uint32_t> order;
+    std::vector<size_type> counts;
+    size_type limit;
+    size_type applied = 0;
+
+    static const key_type &key_of(const value_type &value) {
+        if constexpr (is_map) {
+            return value.first;
+        } else {
+            return value;
+        }
+    }
+
+    void apply(value_type &value) {
+        bool inserted;
+        if constexpr (is_map) {
+            inserted = target.try_emplace(std::move(value.first), std::move(value.second)).second;
+        } else {
+            inserted = target.insert(std::move(value)).second;
+        }
+        applied += inserted;
+    }
+
+    // Removes the first `done` elements of `order` from the buffer after an
+    // insertion threw, keeping the others staged in their original order. Their
+    // region numbers are no longer needed and mark the removed ones.
+    void drop_applied(size_type done) {
+        for (size_type k = 0; k < done; ++k) {
+            regions[order[k]] = UINT32_MAX;
+        }
+        size_type kept = 0;
+        for (size_type i = 0; i < staged.size(); ++i) {
+            if (regions[i] != UINT32_MAX) {
+                if (kept != i) {
+                    staged[kept] = std::move(staged[i]);
+                }
+                ++kept;
+            }
+        }
+        staged.erase(staged.begin() + kept, staged.end());
+    }
+
+public:
+    // At most 2^32 - 1 elements are staged between flushes.
+    explicit IngestBuffer(Table &table, size_type capacity = default_capacity)
+            : target(table), limit(std::clamp<size_type>(capacity, 1, UINT32_MAX)) {
+        staged.reserve(limit);
+    }
+
+    IngestBuffer(const IngestBuffer &) = delete;
+
+    IngestBuffer &operator=(const IngestBuffer &) = delete;
+
+    // Flushes what is left. A destructor must not throw, so an exception from
+    // this last flush is swallowed and the elements still staged are lost; call
+    // `flush` first to see it and retry.
+    ~IngestBuffer() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    void push(const value_type &value) {
+        staged.push_back(value);
+        if (staged.size() >= limit) {
+            flush();
+        }
+    }
+
+    void push(value_type &&value) {
+        staged.push_back(std::move(value));
+        if (staged.size() >= limit) {
+            flush();
+        }
+    }
+
+    template<class... Args>
+    void emplace(Args &&... args) {
+        staged.emplace_back(std::forward<Args>(args)...);
+        if (staged.size() >= limit) {
+            flush();
+        }
+    }
+
+    // Inserts every staged element into the table. Once it returns they are
+    // visible to readers that synchronize with this thread afterwards. If an
+    // insertion throws, the elements inserted before it leave the buffer and the
+    // rest, the failed one included, stay staged for the next flush.
+    void flush() {
+        if (staged.empty()) {
+            return;
+        }
+        // With the table grown up front, home slots usually stay valid during the
+        // pass; if an insertion still rebuilds it only the locality is lost.
+        size_type needed = target.size() + staged.size();
+        if (needed > target.bucket_count()) {
+            target.reserve(std::max(needed, target.bucket_count() * 3));
+        }
+        size_type region_count = (target.bucket_count() >> region_bits) + 1;
+        counts.assign(region_count + 1, 0);
+        regions.resize(staged.size());
+        for (size_type i = 0; i < staged.size(); ++i) {
+            regions[i] = static_cast<std::uint32_t>(target.bucket(key_of(staged[i])) >> region_bits);
+            ++counts[regions[i] + 1];
+        }
+        for (size_type r = 1; r <= region_count; ++r) {
+            counts[r] += counts[r - 1];
+        }
+        order.resize(staged.size());
+        for (size_type i = 0; i < staged.size(); ++i) {
+            order[counts[regions[i]]++] = static_cast<std::uint32_t>(i);
+        }
+        size_type done = 0;
+        try {
+            for (; done < order.size(); ++done) {
+                apply(staged[order[done]]);
+            }
+        } catch (...) {
+            drop_applied(done);
+            throw;
+        }
+        staged.clear();
+    }
+
+    // Drops the staged elements without inserting them.
+    void discard() noexcept {
+        staged.clear();
+    }
+
+    [[nodiscard]] size_type pending() const noexcept {
+        return staged.size();
+    }
+
+    [[nodiscard]] size_type capacity() const noexcept {
+        return limit;
+    }
+
+    // Number of elements inserted into the table by all flushes so far.
+    [[nodiscard]] size_type inserted() const noexcept {
+        return applied;
+    }
+
+    [[nodiscard]] Table &table() noexcept {
+        return target;
+    }
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "prefetch.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Number of lookups `interleaved_probe` keeps in flight; enough to cover the
+// memory latency with the per-step work of a probe.
+constexpr std::size_t interleave_width = 16;
+
+// Whether two addresses share a 64-byte cache line.
+inline bool same_line(const void *a, const void *b) noexcept {
+    return reinterpret_cast<std::uintptr_t>(a) / 64 == reinterpret_cast<std::uintptr_t>(b) / 64;
+}
+
+// Probes the node-based table `slots` (a vector of `unique_ptr<Bucket>` whose
+// buckets from another generation than `slots.generation` count as empty) for the
+// keys of many items at once, in the style of asynchronous memory access
+// chaining: every lookup is a small state machine, and whenever its next step
+// would read a slot or a bucket that is probably not cached, it prefetches that
+// address and yields to the next lookup, so the cache misses of up to
+// `interleave_width` probe sequences overlap.
+//
+// `key_of(item)` gives the key of an input item, `home(key)` its home slot and
+// `matches(bucket, key)` compares a bucket with a key. Once a lookup is resolved,
+// `done(item, slot, found)` is called, with `slot == slots.size()` if the key is
+// absent. `done` may insert into the table; if that rebuilds it, the lookups in
+// flight start over, and in any case their results stay correct because live
+// elements are never removed by an insertion. The items must stay valid while
+// they are in flight.
+//
+// Switching between lookups costs a few mispredicted branches per step, so for
+// tables that fit in cache the plain batched lookups are cheaper.
+template<class CollisionPolicy, class Slots, class InputIt, class KeyOf, class Home, class Matches, class Done>
+void interleaved_probe(const Slots &slots, InputIt first, InputIt last,
+                       KeyOf key_of, Home home, Matches matches, Done done) {
+    using size_type = std::size_t;
+    using Item = std::remove_reference_t<decltype(*first)>;
+
+    struct State {
+        Item *item;
+        size_type ind;
+        size_type cur;
+        size_type step;
+        CollisionPolicy probing;
+        // Whether the bucket of `cur` was prefetched and is due for comparison.
+        bool at_bucket;
+    };
+
+    State states[interleave_width];
+    size_type active = 0;
+    size_type buckets = slots.size();
+
+    auto restart = [&](State &state) {
+        state.ind = home(key_of(*state.item));
+        state.cur = state.ind;
+        state.step = 0;
+        state.probing = CollisionPolicy{};
+        state.at_bucket = false;
+        prefetch(&slots[state.cur]);
+    };
+
+    // Reports a result and restarts every other lookup if the table was rebuilt.
+    auto finish = [&](State &state, size_type slot, bool found) {
+        done(*state.item, slot, found);
+        if (slots.size() != buckets) {
+            buckets = slots.size();
+            for (size_type i = 0; i < active; ++i) {
+                if (&states[i] != &state) {
+                    restart(states[i]);
+                }
+            }
+        }
+    };
+
+    // Starts the next item in `state`; returns `false` once the input is exhausted.
+    auto refill = [&](State &state) {
+        for (; first != last; ++first) {
+            state.item = &*first;
+            if (buckets != 0) {
+                ++first;
+                restart(state);
+                return true;
+            }
+            finish(state, buckets, false);
+        }
+        return false;
+    };
+
+    for (; active < interleave_width && refill(states[active]); ++active) {}
+
+    while (active > 0) {
+        for (size_type i = 0; i < active;) {
+            State &state = states[i];
+            const auto *bucket = slots[state.cur].get();
+            bool resolved = false;
+            bool found = false;
+            if (bucket == nullptr) {
+                resolved = true;
+            } else if (!state.at_bucket) {
+                prefetch(bucket);
+                state.at_bucket = true;
+            } else if (bucket->generation != slots.generation) {
+                resolved = true;
+            } else if (matches(*bucket, key_of(*state.item))) {
+                resolved = true;
+                found = !bucket->is_deleted;
+            } else if (++state.step >= buckets) {
+                resolved = true;
+            } else {
+                const void *line = &slots[state.cur];
+                state.cur = (state.ind + state.probing.next()) % buckets;
+                state.at_bucket = false;
+                if (same_line(line, &slots[state.cur])) {
+                    continue;
+                }
+                prefetch(&slots[state.cur]);
+            }
+            if (!resolved) {
+                ++i;
+                continue;
+            }
+            finish(state, found ? state.cur : slots.size(), found);
+            if (!refill(state)) {
+                state = states[--active];
+            }
+        }
+    }
+}
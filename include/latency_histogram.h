@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Histogram of non-negative integer samples (typically nanoseconds) with a
+// bounded relative error, in the style of HdrHistogram: values below 2^precision
+// get a bucket each, and every further power-of-two range is split into
+// 2^(precision - 1) equal buckets. The default precision of 8 keeps quantiles
+// within 1% of the true value over the full 64-bit range in about 60 KiB.
+class LatencyHistogram {
+public:
+    using size_type = std::size_t;
+
+private:
+    unsigned precision;
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total = 0;
+    std::uint64_t min_value = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t max_value = 0;
+
+    static unsigned log2(std::uint64_t value) noexcept {
+        unsigned result = 0;
+        while (value >>= 1) {
+            ++result;
+        }
+        return result;
+    }
+
+    [[nodiscard]] unsigned shift_of(std::uint64_t value) const noexcept {
+        unsigned exponent = log2(value);
+        return exponent < precision ? 0 : exponent - precision + 1;
+    }
+
+    [[nodiscard]] size_type index_of(std::uint64_t value) const noexcept {
+        unsigned shift = shift_of(value);
+        return (size_type(shift) << (precision - 1)) + (value >> shift);
+    }
+
+    // Largest value that lands in bucket `index`.
+    [[nodiscard]] std::uint64_t highest_in(size_type index) const noexcept {
+        size_type half = size_type(1) << (precision - 1);
+        unsigned shift = index < 2 * half ? 0 : static_cast<unsigned>(index / half - 1);
+        std::uint64_t mantissa = index - (size_type(shift) << (precision - 1));
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+public:
+    explicit LatencyHistogram(unsigned precision_bits = 8) : precision(std::clamp(precision_bits, 1u, 16u)),
+                                                             counts((66 - precision) << (precision - 1)) {}
+
+    void record(std::uint64_t value, std::uint64_t count = 1) noexcept {
+        counts[index_of(value)] += count;
+        total += count;
+        min_value = std::min(min_value, value);
+        max_value = std::max(max_value, value);
+    }
+
+    // Adds the samples of `other`, which must have the same precision.
+    void merge(const LatencyHistogram &other) noexcept {
+        for (size_type i = 0; i < counts.size() && i < other.counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        min_value = std::min(min_value, other.min_value);
+        max_value = std::max(max_value, other.max_value);
+    }
+
+    // Smallest recorded value (up to the bucket precision) that at least
+    // `percent` percent of the samples do not exceed; 0 when empty.
+    [[nodiscard]] std::uint64_t percentile(double percent) const noexcept {
+        if (total == 0) {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(percent, 0.0, 100.0) / 100 * total));
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (size_type i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::clamp(highest_in(i), min_value, max_value);
+            }
+        }
+        return max_value;
+    }
+
+    [[nodiscard]] double mean() const noexcept {
+        if (total == 0) {
+            return 0;
+        }
+        double sum = 0;
+        for (size_type i = 0; i < counts.size(); ++i) {
+            if (counts[i] != 0) {
+                sum += static_cast<double>(counts[i]) * std::min(highest_in(i), max_value);
+            }
+        }
+        return sum / total;
+    }
+
+    void clear() noexcept {
+        std::fill(counts.begin(), counts.end(), 0);
+        total = 0;
+        min_value = std::numeric_limits<std::uint64_t>::max();
+        max_value = 0;
+    }
+
+    [[nodiscard]] std::uint64_t count() const noexcept {
+        return total;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return total == 0;
+    }
+
+    [[nodiscard]] std::uint64_t min() const noexcept {
+        return total == 0 ? 0 : min_value;
+    }
+
+    [[nodiscard]] std::uint64_t max() const noexcept {
+        return max_value;
+    }
+};
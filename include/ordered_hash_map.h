@@ -0,0 +1,488 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Map with packed storage: elements live contiguously in an entries array, and
+// the hash table is a compact array of 32-bit indices into it. Iteration is a
+// linear scan of the entries in insertion order. Erasing moves the last element
+// into the hole, so it changes the position of that one element.
+template<
+        class Key,
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class OrderedHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using reference = std::pair<const Key &, T &>;
+    using const_reference = std::pair<const Key &, const T &>;
+
+private:
+    using index_type = std::uint32_t;
+
+    static constexpr index_type empty_slot = std::numeric_limits<index_type>::max();
+    static constexpr index_type deleted_slot = empty_slot - 1;
+
+    std::vector<std::pair<Key, T>> entries;
+    std::vector<index_type> index;
+    size_type del_count;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    template<class Map, class Ref>
+    class Basic_Iterator {
+        friend class OrderedHashMap;
+
+        template<class, class>
+        friend class Basic_Iterator;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef std::pair<const Key, T> value_type;
+        typedef Ref reference;
+
+        struct pointer {
+            Ref ref;
+
+            Ref *operator->() noexcept {
+                return &ref;
+            }
+        };
+
+    private:
+        Map *map = nullptr;
+        size_type current{};
+
+        Basic_Iterator(Map *m, size_type ind) : map(m), current(ind) {}
+
+        [[nodiscard]] bool at_end() const noexcept {
+            return map == nullptr || current >= map->size();
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        template<class OtherMap, class OtherRef>
+        Basic_Iterator(const Basic_Iterator<OtherMap, OtherRef> &other) : map(other.map), current(other.current) {}
+
+        reference operator*() const {
+            if (!at_end()) {
+                return reference(map->entries[current].first, map->entries[current].second);
+            }
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+
+        pointer operator->() const {
+            return pointer{operator*()};
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (!at_end()) {
+                ++current;
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator==(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return at_end() ? other.at_end() : !other.at_end() && current == other.current;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator!=(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return !(*this == other);
+        }
+    };
+
+public:
+    using iterator = Basic_Iterator<OrderedHashMap, reference>;
+    using const_iterator = Basic_Iterator<const OrderedHashMap, const_reference>;
+
+    explicit OrderedHashMap(size_type expected_max_size = 0,
+                            const hasher &hash = hasher(),
+                            const key_equal &equal = key_equal()) : index(expected_max_size * 2 + 1, empty_slot),
+                                                                    del_count(0), hash_fn(hash), equal_fn(equal) {
+        entries.reserve(expected_max_size);
+    }
+
+    template<class InputIt>
+    OrderedHashMap(InputIt first, InputIt last,
+                   size_type expected_max_size = 0,
+                   const hasher &hash = hasher(),
+                   const key_equal &equal = key_equal()) : OrderedHashMap(expected_max_size, hash, equal) {
+        insert(first, last);
+    }
+
+    OrderedHashMap(std::initializer_list<value_type> init,
+                   size_type expected_max_size = 0,
+                   const hasher &hash = hasher(),
+                   const key_equal &equal = key_equal()) : OrderedHashMap(expected_max_size, hash, equal) {
+        insert(init);
+    }
+
+    OrderedHashMap(const OrderedHashMap &other) = default;
+
+    // Steals the entries of `other`, which is left empty.
+    OrderedHashMap(OrderedHashMap &&other) noexcept : entries(std::move(other.entries)),
+                                                      index(std::move(other.index)),
+                                                      del_count(std::exchange(other.del_count, 0)),
+                                                      hash_fn(std::move(other.hash_fn)),
+                                                      equal_fn(std::move(other.equal_fn)) {
+        other.entries.clear();
+        other.index.clear();
+    }
+
+    OrderedHashMap &operator=(const OrderedHashMap &other) {
+        if (this != &other) {
+            OrderedHashMap t(other);
+            swap(t);
+        }
+        return *this;
+    }
+
+    OrderedHashMap &operator=(OrderedHashMap &&other) noexcept {
+        if (this != &other) {
+            swap(other);
+            other.entries.clear();
+            other.index.clear();
+            other.del_count = 0;
+        }
+        return *this;
+    }
+
+    void swap(OrderedHashMap &other) noexcept {
+        std::swap(entries, other.entries);
+        std::swap(index, other.index);
+        std::swap(del_count, other.del_count);
+        std::swap(hash_fn, other.hash_fn);
+        std::swap(equal_fn, other.equal_fn);
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator();
+    }
+
+    const_iterator end() const noexcept {
+        return cend();
+    }
+
+    const_iterator cend() const noexcept {
+        return const_iterator();
+    }
+
+private:
+    // Returns the index slot referring to `key` and `true`, or the first reusable
+    // slot on its probe sequence and `false`; `bucket_count()` means the sequence
+    // is exhausted.
+    [[nodiscard]] std::pair<size_type, bool> locate(const key_type &key) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        size_type reusable = bucket_count();
+        for (size_type i = 0; i < bucket_count(); ++i) {
+            if (index[cur] == empty_slot) {
+                return {reusable == bucket_count() ? cur : reusable, false};
+            }
+            if (index[cur] == deleted_slot) {
+                if (reusable == bucket_count()) {
+                    reusable = cur;
+                }
+            } else if (equal_fn(entries[index[cur]].first, key)) {
+                return {cur, true};
+            }
+            cur = (ind + probing_local.next()) % bucket_count();
+        }
+        return {reusable, false};
+    }
+
+    // Returns the index slot referring to entry `pos`.
+    [[nodiscard]] size_type slot_of(size_type pos) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(entries[pos].first);
+        size_type cur = ind;
+        while (index[cur] != pos) {
+            cur = (ind + probing_local.next()) % bucket_count();
+        }
+        return cur;
+    }
+
+    // Rebuilds only the index table; the entries stay where they are.
+    void rebuild(size_type count) {
+        // A moved-from map has no slots; growing it from there starts at one.
+        index.assign(std::max<size_type>(count, 1), empty_slot);
+        del_count = 0;
+        for (size_type i = 0; i < entries.size(); ++i) {
+            auto place = locate(entries[i].first);
+            if (place.first == bucket_count()) {
+                rebuild(bucket_count() * 3);
+                return;
+            }
+            index[place.first] = static_cast<index_type>(i);
+        }
+    }
+
+    // Finds `key` or appends an entry for it built from `args`.
+    template<class K, class... Args>
+    std::pair<size_type, bool> claim(K &&key, Args &&... args) {
+        if ((size() + del_count + 1) * 2 > bucket_count()) {
+            rebuild((size() + 1) * 2 > bucket_count() ? bucket_count() * 3 : bucket_count());
+        }
+        while (true) {
+            auto place = locate(key);
+            if (place.second) {
+                return {index[place.first], false};
+            }
+            if (place.first != bucket_count()) {
+                if (size() >= deleted_slot) {
+                    throw std::length_error("OrderedHashMap holds at most 2^32 - 2 elements");
+                }
+                entries.emplace_back(std::piecewise_construct,
+                                     std::forward_as_tuple(std::forward<K>(key)),
+                                     std::forward_as_tuple(std::forward<Args>(args)...));
+                if (index[place.first] == deleted_slot) {
+                    --del_count;
+                }
+                index[place.first] = static_cast<index_type>(entries.size() - 1);
+                return {entries.size() - 1, true};
+            }
+            rebuild(bucket_count() * 3);
+        }
+    }
+
+    // Removes entry `pos`, whose index slot is `slot`, by moving the last entry
+    // into its place.
+    void erase_entry(size_type pos, size_type slot) {
+        index[slot] = deleted_slot;
+        ++del_count;
+        size_type last = entries.size() - 1;
+        if (pos != last) {
+            index[slot_of(last)] = static_cast<index_type>(pos);
+            entries[pos] = std::move(entries[last]);
+        }
+        entries.pop_back();
+    }
+
+public:
+    std::pair<iterator, bool> insert(const value_type &inserted_value) {
+        return try_emplace(inserted_value.first, inserted_value.second);
+    }
+
+    template<class P>
+    std::pair<iterator, bool> insert(P &&inserted_value) {
+        return try_emplace(std::forward<P>(inserted_value).first, std::forward<P>(inserted_value).second);
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    template<class K, class M>
+    std::pair<iterator, bool> insert_or_assign(K &&key, M &&inserted_value) {
+        auto place = claim(std::forward<K>(key));
+        entries[place.first].second = std::forward<M>(inserted_value);
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args &&... args) {
+        auto place = claim(std::forward<K>(key), std::forward<Args>(args)...);
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> emplace(K &&key, Args &&... args) {
+        return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    // Returns an iterator to the same position, which now holds the element that
+    // used to be last.
+    iterator erase(const_iterator pos) {
+        if (pos == cend()) {
+            return end();
+        }
+        erase_entry(pos.current, slot_of(pos.current));
+        return iterator(this, pos.current);
+    }
+
+    size_type erase(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            return 0;
+        }
+        erase_entry(index[place.first], place.first);
+        return 1;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] iterator find(const key_type &key) {
+        auto place = locate(key);
+        return place.second ? iterator(this, index[place.first]) : end();
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        auto place = locate(key);
+        return place.second ? const_iterator(this, index[place.first]) : cend();
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return locate(key).second;
+    }
+
+    mapped_type &at(const key_type &key) {
+        auto place = locate(key);
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return entries[index[place.first]].second;
+    }
+
+    const mapped_type &at(const key_type &key) const {
+        auto place = locate(key);
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return entries[index[place.first]].second;
+    }
+
+    mapped_type &operator[](const key_type &key) {
+        return entries[claim(key).first].second;
+    }
+
+    mapped_type &operator[](key_type &&key) {
+        return entries[claim(std::move(key)).first].second;
+    }
+
+    // Element at position `pos` of the iteration order.
+    [[nodiscard]] reference nth(size_type pos) {
+        return reference(entries.at(pos).first, entries[pos].second);
+    }
+
+    [[nodiscard]] const_reference nth(size_type pos) const {
+        return const_reference(entries.at(pos).first, entries[pos].second);
+    }
+
+    void clear() noexcept {
+        entries.clear();
+        std::fill(index.begin(), index.end(), empty_slot);
+        del_count = 0;
+    }
+
+    [[nodiscard]] size_type bucket_size(const size_type) const noexcept {
+        return 1;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return entries.size();
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return index.size();
+    }
+
+    [[nodiscard]] size_type max_bucket_count() const noexcept {
+        return index.max_size();
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return deleted_slot;
+    }
+
+    // A moved-from map has no slots; every key then maps to the (absent) slot 0.
+    [[nodiscard]] size_type bucket(const key_type &key) const {
+        return bucket_count() == 0 ? 0 : apply_hash(hash_fn, key) % bucket_count();
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return static_cast<float>(size()) / bucket_count();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 0.5;
+    }
+
+    void rehash(const size_type count) {
+        if (count > bucket_count() || del_count > 0) {
+            rebuild(std::max(count, bucket_count()));
+        }
+    }
+
+    void reserve(size_type count) {
+        entries.reserve(count);
+        if (count * 2 + 1 > bucket_count()) {
+            rebuild(count * 2 + 1);
+        }
+    }
+
+    // Releases spare entry capacity and drops tombstones from the index.
+    void shrink_to_fit() {
+        entries.shrink_to_fit();
+        rebuild(size() * 2 + 1);
+    }
+
+    friend bool operator==(const OrderedHashMap &first, const OrderedHashMap &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (const auto &entry : first.entries) {
+            auto place = second.locate(entry.first);
+            if (!place.second || second.entries[second.index[place.first]].second != entry.second) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const OrderedHashMap &first, const OrderedHashMap &second) {
+        return !(first == second);
+    }
+};
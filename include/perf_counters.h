@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum class PerfEvent {
+    Cycles,
+    Instructions,
+    L1DMisses,
+    LLCMisses,
+    DTLBMisses,
+    BranchMisses,
+};
+
+// Hardware counters of the calling thread, read with `perf_event_open`. Every
+// event is opened on its own, so a CPU or VM that lacks some of them (or a
+// kernel that forbids them, see perf_event_paranoid) still reports the rest;
+// `available` tells which ones work. When the kernel multiplexes counters the
+// values are scaled up by the fraction of time each was running.
+class PerfCounters {
+public:
+    static constexpr std::size_t event_count = 6;
+
+    struct Sample {
+        double values[event_count] = {};
+        bool valid[event_count] = {};
+
+        [[nodiscard]] double operator[](PerfEvent event) const noexcept {
+            return values[static_cast<std::size_t>(event)];
+        }
+
+        [[nodiscard]] bool has(PerfEvent event) const noexcept {
+            return valid[static_cast<std::size_t>(event)];
+        }
+    };
+
+private:
+    int fds[event_count];
+
+#if defined(__linux__)
+    static bool describe(PerfEvent event, perf_event_attr &attr) noexcept {
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        auto cache = [&](std::uint64_t id, std::uint64_t op) {
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = id | (op << 8) | (std::uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+        };
+        switch (event) {
+            case PerfEvent::Cycles:
+                attr.config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PerfEvent::Instructions:
+                attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PerfEvent::L1DMisses:
+                cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ);
+                break;
+            case PerfEvent::LLCMisses:
+                attr.config = PERF_COUNT_HW_CACHE_MISSES;
+                break;
+            case PerfEvent::DTLBMisses:
+                cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ);
+                break;
+            case PerfEvent::BranchMisses:
+                attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            default:
+                return false;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return true;
+    }
+#endif
+
+public:
+    PerfCounters() noexcept {
+        for (std::size_t i = 0; i < event_count; ++i) {
+            fds[i] = -1;
+#if defined(__linux__)
+            perf_event_attr attr;
+            if (describe(static_cast<PerfEvent>(i), attr)) {
+                fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+#endif
+        }
+    }
+
+    PerfCounters(const PerfCounters &) = delete;
+
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    [[nodiscard]] bool available(PerfEvent event) const noexcept {
+        return fds[static_cast<std::size_t>(event)] >= 0;
+    }
+
+    [[nodiscard]] bool any_available() const noexcept {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Zeroes and enables every available counter.
+    void start() noexcept {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    void stop() noexcept {
+#if defined(__linux__)
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // Counts since the last `start`.
+    [[nodiscard]] Sample read() const noexcept {
+        Sample sample;
+#if defined(__linux__)
+        for (std::size_t i = 0; i < event_count; ++i) {
+            std::uint64_t data[3];
+            if (fds[i] < 0 || ::read(fds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+                continue;
+            }
+            if (data[2] == 0) {
+                // Never scheduled on a hardware counter.
+                continue;
+            }
+            sample.values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+            sample.valid[i] = true;
+        }
+#endif
+        return sample;
+    }
+
+    static const char *name(PerfEvent event) noexcept {
+        switch (event) {
+            case PerfEvent::Cycles:
+                return "cycles";
+            case PerfEvent::Instructions:
+                return "instructions";
+            case PerfEvent::L1DMisses:
+                return "L1d-misses";
+            case PerfEvent::LLCMisses:
+                return "LLC-misses";
+            case PerfEvent::DTLBMisses:
+                return "dTLB-misses";
+            case PerfEvent::BranchMisses:
+                return "branch-misses";
+            default:
+                return "unknown";
+        }
+    }
+};
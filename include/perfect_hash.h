@@ -0,0 +1,187 @@
+#pragma once
+
+#include "binary_io.h"
+#include "hash_functions.h"
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Minimal perfect hash over a fixed set of distinct 64-bit hashes, built in the
+// style of PTHash: hashes are split into small buckets, and every bucket gets a
+// pilot value chosen so that all of its hashes land on free, distinct positions
+// in [0, size()). Buckets are placed largest first, and a new seed is tried if
+// some bucket runs out of pilots. Evaluating it is one pilot read and three mixes:
+// one for the bucket, one of the pilot and one for the position.
+class PerfectHash {
+public:
+    using size_type = std::size_t;
+
+private:
+    static constexpr std::uint64_t magic = 0x3148505048534148ULL;  // "HASHPPH1"
+    static constexpr size_type keys_per_bucket = 4;
+
+    std::uint64_t seed = 0;
+    std::uint64_t slot_count = 0;
+    std::vector<std::uint32_t> pilots;
+
+    [[nodiscard]] size_type bucket_of(std::uint64_t hash) const noexcept {
+        return hash_mix(hash ^ seed) % pilots.size();
+    }
+
+    [[nodiscard]] size_type position(std::uint64_t hash, std::uint32_t pilot) const noexcept {
+        return hash_mix(hash ^ hash_mix(seed + pilot * 0x9e3779b97f4a7c15ULL)) % slot_count;
+    }
+
+    // Tries to place every bucket with the current seed.
+    bool try_build(const std::vector<std::uint64_t> &hashes) {
+        size_type bucket_count = pilots.size();
+        std::vector<std::uint32_t> bucket_size(bucket_count + 1);
+        for (auto hash : hashes) {
+            ++bucket_size[bucket_of(hash) + 1];
+        }
+        // Counting sort of the hashes by bucket.
+        std::vector<size_type> bucket_start(bucket_count + 1);
+        for (size_type b = 0; b < bucket_count; ++b) {
+            bucket_start[b + 1] = bucket_start[b] + bucket_size[b + 1];
+        }
+        std::vector<std::uint64_t> sorted(hashes.size());
+        std::vector<size_type> fill(bucket_start.begin(), bucket_start.end() - 1);
+        for (auto hash : hashes) {
+            sorted[fill[bucket_of(hash)]++] = hash;
+        }
+        std::vector<size_type> order(bucket_count);
+        for (size_type b = 0; b < bucket_count; ++b) {
+            order[b] = b;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_type a, size_type b) {
+            return bucket_size[a + 1] > bucket_size[b + 1];
+        });
+
+        std::vector<bool> taken(slot_count);
+        std::vector<size_type> placed;
+        std::uint64_t max_pilot = std::min<std::uint64_t>(std::numeric_limits<std::uint32_t>::max(),
+                                                          std::max<std::uint64_t>(1 << 16, slot_count * 16));
+        for (size_type b : order) {
+            if (bucket_size[b + 1] == 0) {
+                break;
+            }
+            bool done = false;
+            for (std::uint64_t pilot = 0; pilot < max_pilot && !done; ++pilot) {
+                placed.clear();
+                done = true;
+                for (size_type i = bucket_start[b]; i < bucket_start[b + 1]; ++i) {
+                    size_type pos = position(sorted[i], static_cast<std::uint32_t>(pilot));
+                    if (taken[pos]) {
+                        done = false;
+                        break;
+                    }
+                    taken[pos] = true;
+                    placed.push_back(pos);
+                }
+                if (done) {
+                    pilots[b] = static_cast<std::uint32_t>(pilot);
+                } else {
+                    for (size_type pos : placed) {
+                        taken[pos] = false;
+                    }
+                }
+            }
+            if (!done) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    PerfectHash() = default;
+
+    // `hashes` must be distinct; equal hashes can never be separated.
+    explicit PerfectHash(const std::vector<std::uint64_t> &hashes) : slot_count(hashes.size()) {
+        if (hashes.empty()) {
+            return;
+        }
+        pilots.resize((hashes.size() + keys_per_bucket - 1) / keys_per_bucket);
+        for (std::uint64_t attempt = 0;; ++attempt) {
+            seed = hash_mix(attempt + 1);
+            std::fill(pilots.begin(), pilots.end(), 0);
+            if (try_build(hashes)) {
+                return;
+            }
+            if (attempt == 64) {
+                throw std::invalid_argument("Perfect hash construction failed; are the hashes distinct?");
+            }
+        }
+    }
+
+    // Position of `hash` in [0, size()). Hashes outside the build set map to an
+    // arbitrary position, so callers compare the key stored there.
+    [[nodiscard]] size_type operator()(std::uint64_t hash) const noexcept {
+        return position(hash, pilots[bucket_of(hash)]);
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return slot_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return slot_count == 0;
+    }
+
+    // Bytes of pilot data, about one byte per key.
+    [[nodiscard]] size_type memory_usage() const noexcept {
+        return pilots.size() * sizeof(std::uint32_t);
+    }
+
+    void save(std::ostream &out) const {
+        std::uint64_t header[4] = {magic, seed, slot_count, pilots.size()};
+        write_binary(out, header, 4);
+        write_binary(out, pilots.data(), pilots.size());
+    }
+
+    static PerfectHash load(std::istream &in) {
+        std::uint64_t header[4];
+        read_binary(in, header, 4);
+        if (header[0] != magic || header[3] != (header[2] + keys_per_bucket - 1) / keys_per_bucket) {
+            throw std::runtime_error("Not a perfect hash");
+        }
+        PerfectHash result;
+        result.seed = header[1];
+        result.slot_count = header[2];
+        result.pilots.resize(header[3]);
+        read_binary(in, result.pilots.data(), result.pilots.size());
+        return result;
+    }
+};
+
+// Indices of the first occurrence of every distinct key, given the keys' hashes
+// and `same(i, j)` comparing the keys at two positions with equal hashes. Two
+// different keys with the same hash cannot be told apart by any perfect hash,
+// so they are rejected.
+template<class Same>
+std::vector<std::size_t> distinct_by_hash(const std::vector<std::uint64_t> &hashes, Same same) {
+    std::vector<std::size_t> order(hashes.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return hashes[a] < hashes[b];
+    });
+    std::vector<std::size_t> result;
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        if (i > 0 && hashes[order[i]] == hashes[result.back()]) {
+            if (!same(result.back(), order[i])) {
+                throw std::invalid_argument("Different keys with equal hashes cannot be frozen");
+            }
+            continue;
+        }
+        result.push_back(order[i]);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
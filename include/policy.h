@@ -3,35 +3,35 @@
 #include <cstdlib>
 
 class LinearProbing {
-    size_t ind;
+    size_t ind = 0;
 
 public:
-    LinearProbing() {
+    constexpr LinearProbing() {
         start();
     }
 
-    void start() {
+    constexpr void start() {
         ind = 0;
     }
 
-    size_t next() {
+    constexpr size_t next() {
         return ++ind;
     }
 };
 
 class QuadraticProbing {
-    size_t ind;
+    size_t ind = 0;
 
 public:
-    QuadraticProbing() {
+    constexpr QuadraticProbing() {
         start();
     }
 
-    void start() {
+    constexpr void start() {
         ind = 0;
     }
 
-    size_t next() {
+    constexpr size_t next() {
         ++ind;
         return ind * ind;
     }
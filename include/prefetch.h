@@ -0,0 +1,11 @@
+#pragma once
+
+// Asks the CPU to start loading the cache line holding `ptr`, so that a later
+// access overlaps with other work instead of stalling on memory.
+inline void prefetch(const void *ptr) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(ptr);
+#else
+    (void) ptr;
+#endif
+}
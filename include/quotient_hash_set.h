@@ -0,0 +1,523 @@
+#pragma once
+
+#include "hash_functions.h"
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Exact set of integers laid out like a quotient filter. A key is scrambled by
+// `hash_mix`, which is a bijection on 64-bit words; the high `quotient_bits()`
+// bits of the result select the home slot and only the remaining low bits are
+// stored, bit-packed with three metadata bits per slot. Since the permutation
+// can be inverted nothing is lost: there are no false positives and iteration
+// yields the original keys. Elements with the same home form a run sorted by
+// remainder, runs are kept in the order of their homes, and runs pushed out of
+// their home are shifted right as in linear probing, so a lookup reads a few
+// consecutive slots. With 2^20 slots a slot takes 47 bits, where HashSet needs a
+// pointer and a heap node per slot.
+template<class Key = std::uint64_t>
+class QuotientHashSet {
+    static_assert(std::is_integral_v<Key> && sizeof(Key) <= sizeof(std::uint64_t),
+                  "QuotientHashSet stores integers of at most 64 bits");
+
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    // Metadata bits of a slot, below the remainder.
+    enum : std::uint64_t {
+        // Some element has this slot as its home.
+        occupied_bit = 1,
+        // The element belongs to the same run as the one in the previous slot.
+        continuation_bit = 2,
+        // The element is not in its home slot.
+        shifted_bit = 4,
+        meta_bits = 3,
+    };
+
+    static constexpr unsigned min_quotient_bits = 6;
+
+    // An element of a cluster, with its home relative to the first slot.
+    struct Entry {
+        size_type home;
+        std::uint64_t remainder;
+
+        friend bool operator<(const Entry &a, const Entry &b) {
+            return a.home != b.home ? a.home < b.home : a.remainder < b.remainder;
+        }
+    };
+
+    std::vector<std::uint64_t> words;
+    unsigned qbits = min_quotient_bits;
+    size_type el_count = 0;
+    std::vector<Entry> entries;
+    std::vector<size_type> homes;
+
+    [[nodiscard]] unsigned rbits() const noexcept {
+        return 64 - qbits;
+    }
+
+    [[nodiscard]] unsigned width() const noexcept {
+        return rbits() + meta_bits;
+    }
+
+    [[nodiscard]] size_type mask() const noexcept {
+        return bucket_count() - 1;
+    }
+
+    [[nodiscard]] size_type next(size_type i) const noexcept {
+        return (i + 1) & mask();
+    }
+
+    [[nodiscard]] size_type prev(size_type i) const noexcept {
+        return (i - 1) & mask();
+    }
+
+    [[nodiscard]] std::uint64_t get(size_type i) const noexcept {
+        size_type bit = i * width();
+        size_type word = bit / 64;
+        unsigned offset = bit % 64;
+        std::uint64_t value = words[word] >> offset;
+        if (offset + width() > 64) {
+            value |= words[word + 1] << (64 - offset);
+        }
+        return value & ((std::uint64_t(1) << width()) - 1);
+    }
+
+    void set(size_type i, std::uint64_t value) noexcept {
+        size_type bit = i * width();
+        size_type word = bit / 64;
+        unsigned offset = bit % 64;
+        std::uint64_t field = (std::uint64_t(1) << width()) - 1;
+        words[word] = (words[word] & ~(field << offset)) | (value << offset);
+        if (offset + width() > 64) {
+            unsigned high = 64 - offset;
+            words[word + 1] = (words[word + 1] & ~(field >> high)) | (value >> high);
+        }
+    }
+
+    [[nodiscard]] bool is_empty(size_type i) const noexcept {
+        return (get(i) & ((1 << meta_bits) - 1)) == 0;
+    }
+
+    [[nodiscard]] bool is_occupied(size_type i) const noexcept {
+        return get(i) & occupied_bit;
+    }
+
+    [[nodiscard]] bool is_continuation(size_type i) const noexcept {
+        return get(i) & continuation_bit;
+    }
+
+    [[nodiscard]] bool is_shifted(size_type i) const noexcept {
+        return get(i) & shifted_bit;
+    }
+
+    [[nodiscard]] std::uint64_t remainder(size_type i) const noexcept {
+        return get(i) >> meta_bits;
+    }
+
+    [[nodiscard]] std::pair<size_type, std::uint64_t> split(const key_type &key) const noexcept {
+        std::uint64_t h = hash_mix(static_cast<std::uint64_t>(key));
+        return {static_cast<size_type>(h >> rbits()), h & ((std::uint64_t(1) << rbits()) - 1)};
+    }
+
+    [[nodiscard]] key_type join(size_type home, std::uint64_t rem) const noexcept {
+        return static_cast<key_type>(hash_unmix((std::uint64_t(home) << rbits()) | rem));
+    }
+
+    // First slot of the run of `home`, which must be occupied: walks back to the
+    // start of the cluster and then forward over one run per occupied home.
+    [[nodiscard]] size_type run_start(size_type home) const noexcept {
+        size_type b = home;
+        while (is_shifted(b)) {
+            b = prev(b);
+        }
+        size_type s = b;
+        while (b != home) {
+            do {
+                s = next(s);
+            } while (is_continuation(s));
+            do {
+                b = next(b);
+            } while (!is_occupied(b));
+        }
+        return s;
+    }
+
+    // Slot of the element, or `bucket_count()` if it is absent.
+    [[nodiscard]] size_type locate(size_type home, std::uint64_t rem) const noexcept {
+        if (!is_occupied(home)) {
+            return bucket_count();
+        }
+        size_type i = run_start(home);
+        do {
+            std::uint64_t r = remainder(i);
+            if (r == rem) {
+                return i;
+            }
+            if (r > rem) {
+                break;
+            }
+            i = next(i);
+        } while (is_continuation(i));
+        return bucket_count();
+    }
+
+    // First slot of the maximal range of filled slots around `i`; its element is
+    // always in its home slot.
+    [[nodiscard]] size_type block_start(size_type i) const noexcept {
+        while (!is_empty(prev(i))) {
+            i = prev(i);
+        }
+        return i;
+    }
+
+    // Reads the range of filled slots starting at `start` into `entries`. A new
+    // run belongs to the earliest occupied home not yet matched with a run.
+    void decode(size_type start) {
+        entries.clear();
+        homes.clear();
+        size_type matched = 0;
+        size_type home = 0;
+        for (size_type k = 0, i = start; !is_empty(i); ++k, i = next(i)) {
+            if (is_occupied(i)) {
+                homes.push_back(k);
+            }
+            if (!is_continuation(i)) {
+                home = homes[matched++];
+            }
+            entries.push_back({home, remainder(i)});
+        }
+    }
+
+    // Writes the sorted `entries` back from `start`, over the `old_length` slots
+    // they were decoded from; every element goes to its home or right after the
+    // previous one, whichever comes later.
+    void layout(size_type start, size_type old_length) noexcept {
+        for (size_type k = 0, i = start; k < old_length; ++k, i = next(i)) {
+            set(i, 0);
+        }
+        for (const auto &e : entries) {
+            size_type i = (start + e.home) & mask();
+            set(i, get(i) | occupied_bit);
+        }
+        size_type pos = 0;
+        for (size_type k = 0; k < entries.size(); ++k) {
+            const auto &e = entries[k];
+            pos = std::max(pos, e.home);
+            size_type i = (start + pos) & mask();
+            std::uint64_t meta = get(i) & occupied_bit;
+            if (k > 0 && entries[k - 1].home == e.home) {
+                meta |= continuation_bit;
+            }
+            if (pos != e.home) {
+                meta |= shifted_bit;
+            }
+            set(i, (e.remainder << meta_bits) | meta);
+            ++pos;
+        }
+    }
+
+    // Adds an element that is known to be absent; there must be a free slot.
+    void place(size_type home, std::uint64_t rem) {
+        ++el_count;
+        if (is_empty(home)) {
+            set(home, (rem << meta_bits) | occupied_bit);
+            return;
+        }
+        size_type start = block_start(home);
+        decode(start);
+        size_type length = entries.size();
+        Entry entry{(home - start) & mask(), rem};
+        entries.insert(std::upper_bound(entries.begin(), entries.end(), entry), entry);
+        layout(start, length);
+    }
+
+    void rebuild(unsigned quotient_bits) {
+        QuotientHashSet t;
+        t.qbits = quotient_bits;
+        t.words.assign((t.bucket_count() * t.width() + 63) / 64 + 1, 0);
+        for (auto it = begin(); it != end(); ++it) {
+            auto parts = t.split(*it);
+            t.place(parts.first, parts.second);
+        }
+        swap(t);
+    }
+
+    [[nodiscard]] static unsigned quotient_bits_for(size_type count) noexcept {
+        unsigned bits = min_quotient_bits;
+        while (bits < 63 && (size_type(1) << bits) - (size_type(1) << bits) / 4 < count) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    class Basic_Iterator {
+        friend class QuotientHashSet;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef const Key value_type;
+        typedef void pointer;
+        typedef Key reference;
+
+    private:
+        const QuotientHashSet *set = nullptr;
+        // Slots are visited from `origin`, which follows an empty slot, so that no
+        // cluster is cut in two.
+        size_type origin{};
+        size_type step{};
+        size_type home{};
+
+        Basic_Iterator(const QuotientHashSet *s, size_type from) : set(s), origin(from) {
+            skip_empty();
+        }
+
+        [[nodiscard]] size_type slot() const noexcept {
+            return (origin + step) & set->mask();
+        }
+
+        void skip_empty() noexcept {
+            while (step < set->bucket_count() && set->is_empty(slot())) {
+                ++step;
+            }
+            home = slot();
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        reference operator*() const {
+            if (set != nullptr && step < set->bucket_count()) {
+                return set->join(home, set->remainder(slot()));
+            }
+            throw std::out_of_range("Trying to access a value of the end iterator");
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (set == nullptr || step >= set->bucket_count()) {
+                return *this;
+            }
+            ++step;
+            if (step >= set->bucket_count() || set->is_empty(slot())) {
+                skip_empty();
+            } else if (!set->is_continuation(slot())) {
+                do {
+                    home = set->next(home);
+                } while (!set->is_occupied(home));
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            bool end1 = it1.set == nullptr || it1.step >= it1.set->bucket_count();
+            bool end2 = it2.set == nullptr || it2.step >= it2.set->bucket_count();
+            return end1 ? end2 : !end2 && it1.set == it2.set && it1.slot() == it2.slot();
+        }
+
+        friend bool operator!=(const Basic_Iterator &it1, const Basic_Iterator &it2) {
+            return !(it1 == it2);
+        }
+    };
+
+public:
+    using const_iterator = Basic_Iterator;
+    using iterator = const_iterator;
+
+    explicit QuotientHashSet(size_type expected_max_size = 0) : qbits(quotient_bits_for(expected_max_size)) {
+        words.assign((bucket_count() * width() + 63) / 64 + 1, 0);
+    }
+
+    template<class InputIt>
+    QuotientHashSet(InputIt first, InputIt last, size_type expected_max_size = 0)
+            : QuotientHashSet(expected_max_size) {
+        insert(first, last);
+    }
+
+    QuotientHashSet(std::initializer_list<value_type> init, size_type expected_max_size = 0)
+            : QuotientHashSet(init.begin(), init.end(), expected_max_size) {}
+
+    QuotientHashSet(const QuotientHashSet &) = default;
+
+    // Leaves `other` as a new empty table with the fewest slots. That takes a
+    // small allocation, so moves are not noexcept.
+    QuotientHashSet(QuotientHashSet &&other) : QuotientHashSet() {
+        swap(other);
+    }
+
+    QuotientHashSet &operator=(const QuotientHashSet &) = default;
+
+    QuotientHashSet &operator=(QuotientHashSet &&other) {
+        if (this != &other) {
+            QuotientHashSet fresh;
+            swap(other);
+            other.swap(fresh);
+        }
+        return *this;
+    }
+
+    void swap(QuotientHashSet &other) noexcept {
+        std::swap(words, other.words);
+        std::swap(qbits, other.qbits);
+        std::swap(el_count, other.el_count);
+        std::swap(entries, other.entries);
+        std::swap(homes, other.homes);
+    }
+
+    [[nodiscard]] const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    [[nodiscard]] const_iterator cbegin() const noexcept {
+        // Starts after an empty slot, of which the load limit always leaves one.
+        size_type i = 0;
+        while (i < bucket_count() && !is_empty(i)) {
+            ++i;
+        }
+        return Basic_Iterator(this, next(i));
+    }
+
+    [[nodiscard]] const_iterator end() const noexcept {
+        return cend();
+    }
+
+    [[nodiscard]] const_iterator cend() const noexcept {
+        return Basic_Iterator();
+    }
+
+    // Returns whether the key was added; the table doubles at 3/4 load.
+    bool insert(const key_type &key) {
+        auto parts = split(key);
+        if (locate(parts.first, parts.second) != bucket_count()) {
+            return false;
+        }
+        if (size() + 1 > max_load()) {
+            rebuild(qbits + 1);
+            parts = split(key);
+        }
+        place(parts.first, parts.second);
+        return true;
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    // Elements of the cluster after the erased one move back towards their homes,
+    // so no tombstones are left behind.
+    size_type erase(const key_type &key) {
+        auto parts = split(key);
+        size_type slot = locate(parts.first, parts.second);
+        if (slot == bucket_count()) {
+            return 0;
+        }
+        size_type start = block_start(slot);
+        decode(start);
+        size_type length = entries.size();
+        Entry entry{(parts.first - start) & mask(), parts.second};
+        entries.erase(std::lower_bound(entries.begin(), entries.end(), entry));
+        layout(start, length);
+        --el_count;
+        return 1;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        auto parts = split(key);
+        return locate(parts.first, parts.second) != bucket_count();
+    }
+
+    void clear() noexcept {
+        std::fill(words.begin(), words.end(), 0);
+        el_count = 0;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return size_type(1) << qbits;
+    }
+
+    [[nodiscard]] unsigned quotient_bits() const noexcept {
+        return qbits;
+    }
+
+    [[nodiscard]] unsigned remainder_bits() const noexcept {
+        return rbits();
+    }
+
+    // Bits of storage per slot: the remainder and the metadata.
+    [[nodiscard]] unsigned bits_per_slot() const noexcept {
+        return width();
+    }
+
+    [[nodiscard]] size_type memory_usage() const noexcept {
+        return words.size() * sizeof(std::uint64_t);
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return static_cast<float>(size()) / bucket_count();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 0.75;
+    }
+
+    [[nodiscard]] size_type max_load() const noexcept {
+        return bucket_count() - bucket_count() / 4;
+    }
+
+    void reserve(size_type count) {
+        unsigned bits = quotient_bits_for(count);
+        if (bits > qbits) {
+            rebuild(bits);
+        }
+    }
+
+    friend bool operator==(const QuotientHashSet &first, const QuotientHashSet &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (auto it = first.begin(); it != first.end(); ++it) {
+            if (!second.contains(*it)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const QuotientHashSet &first, const QuotientHashSet &second) {
+        return !(first == second);
+    }
+};
@@ -0,0 +1,312 @@
+#pragma once
+
+#include "binary_io.h"
+#include "hash_map.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Map for aggregations larger than memory. Keys are hash-partitioned into a
+// fixed number of partitions, each held in a HashMap while it is resident. When
+// the estimated footprint of the resident partitions exceeds the memory budget,
+// the largest one is written to its own file in `directory` and dropped; later
+// updates of that partition are appended to the file as records in large
+// sequential writes. Values of equal keys are merged as `combine(old, new)`, so
+// a spilled file may hold a key several times until `for_each` reads the
+// partitions back one at a time and merges them. Choose the partition count so
+// that one partition fits in the budget. Keys and values are spilled as raw
+// bytes and must be trivially copyable.
+template<
+        class Key,
+        class T,
+        class Combine = std::plus<T>,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class SpillingHashMap {
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<T>,
+                  "Spilled keys and values are written as raw bytes");
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using combiner = Combine;
+    using table_type = HashMap<Key, T, CollisionPolicy, Hash, Equal>;
+
+    static constexpr size_type default_partitions = 64;
+
+    // Bounds on the records a spilled partition buffers before writing them out.
+    static constexpr size_type max_write_batch = 4096;
+    static constexpr size_type min_write_batch = 64;
+
+private:
+    struct Record {
+        Key key;
+        T value;
+    };
+
+    struct Partition {
+        table_type table;
+        std::filesystem::path path;
+        std::fstream file;
+        std::vector<Record> pending;
+        size_type records = 0;
+
+        Partition(const hasher &hash, const key_equal &equal) : table(0, hash, equal) {}
+
+        [[nodiscard]] bool spilled() const {
+            return file.is_open();
+        }
+    };
+
+    std::vector<Partition> parts;
+    std::filesystem::path directory;
+    std::string file_prefix;
+    size_type budget;
+    size_type batch;
+    size_type resident_bytes = 0;
+    hasher hash_fn;
+    key_equal equal_fn;
+    combiner combine_fn;
+
+    // Write buffer size that gives the buffers of all partitions at most a quarter
+    // of the budget.
+    [[nodiscard]] static size_type batch_for(size_type memory_budget, size_type partitions) noexcept {
+        return std::min(max_write_batch, memory_budget / 4 / std::max<size_type>(partitions, 1) / sizeof(Record));
+    }
+
+    // Estimated heap use of a resident table: a slot pointer per bucket, and per
+    // element a node with the allocator's bookkeeping.
+    [[nodiscard]] static size_type footprint(const table_type &table) noexcept {
+        return table.bucket_count() * sizeof(void *) + table.size() * (sizeof(value_type) + 2 * sizeof(void *));
+    }
+
+    [[nodiscard]] size_type partition(const key_type &key) const {
+        // The high bits of the hash, as the tables index by the hash modulo their size.
+        auto h = static_cast<std::uint64_t>(apply_hash(hash_fn, key));
+        return static_cast<size_type>(((h >> 32) * parts.size()) >> 32);
+    }
+
+    void merge_into(table_type &table, const key_type &key, const mapped_type &value) {
+        auto result = table.try_emplace(key, value);
+        if (!result.second) {
+            result.first->second = combine_fn(result.first->second, value);
+        }
+    }
+
+    void write_pending(Partition &part) {
+        write_binary(part.file, part.pending.data(), part.pending.size());
+        if (!part.file) {
+            throw std::runtime_error("Failed to write spill file " + part.path.string());
+        }
+        part.records += part.pending.size();
+        part.pending.clear();
+    }
+
+    void spill(Partition &part) {
+        part.path = directory / (file_prefix + std::to_string(&part - parts.data()));
+        part.file.open(part.path, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!part.file.is_open()) {
+            throw std::runtime_error("Cannot create spill file " + part.path.string());
+        }
+        resident_bytes -= footprint(part.table);
+        part.pending.reserve(batch);
+        resident_bytes += batch * sizeof(Record);
+        for (const auto &kv : part.table) {
+            part.pending.push_back({kv.first, kv.second});
+            if (part.pending.size() == batch) {
+                write_pending(part);
+            }
+        }
+        write_pending(part);
+        part.table = table_type(0, hash_fn, equal_fn);
+    }
+
+    // Spills the largest resident partition; `false` if none holds elements.
+    bool spill_largest() {
+        Partition *victim = nullptr;
+        for (auto &part : parts) {
+            if (!part.spilled() && !part.table.empty()
+                && (victim == nullptr || footprint(part.table) > footprint(victim->table))) {
+                victim = &part;
+            }
+        }
+        if (victim == nullptr) {
+            return false;
+        }
+        spill(*victim);
+        return true;
+    }
+
+    // Reads a spilled partition back into `table`, merging repeated keys.
+    void load(Partition &part, table_type &table) {
+        write_pending(part);
+        part.file.seekg(0);
+        std::vector<Record> chunk(std::min(part.records, batch));
+        for (size_type done = 0; done < part.records;) {
+            size_type count = std::min(part.records - done, batch);
+            read_binary(part.file, chunk.data(), count);
+            for (size_type i = 0; i < count; ++i) {
+                merge_into(table, chunk[i].key, chunk[i].value);
+            }
+            done += count;
+        }
+        part.file.seekp(0, std::ios::end);
+    }
+
+    void remove_files() noexcept {
+        for (auto &part : parts) {
+            if (part.spilled()) {
+                part.file.close();
+                std::error_code ignored;
+                std::filesystem::remove(part.path, ignored);
+            }
+        }
+    }
+
+public:
+    // `memory_budget` is in bytes and covers the resident tables and the write
+    // buffers of spilled partitions. It must leave room for buffers of at least
+    // `min_write_batch` records per partition.
+    explicit SpillingHashMap(size_type memory_budget,
+                             size_type partitions = default_partitions,
+                             const std::filesystem::path &spill_directory = std::filesystem::temp_directory_path(),
+                             const hasher &hash = hasher(),
+                             const key_equal &equal = key_equal(),
+                             const combiner &combine = combiner()) : directory(spill_directory),
+                                                                     budget(memory_budget),
+                                                                     batch(batch_for(memory_budget, partitions)),
+                                                                     hash_fn(hash), equal_fn(equal),
+                                                                     combine_fn(combine) {
+        if (partitions == 0) {
+            throw std::invalid_argument("SpillingHashMap needs at least one partition");
+        }
+        if (batch < min_write_batch) {
+            throw std::invalid_argument("Memory budget too small for the write buffers of all partitions");
+        }
+        parts.reserve(partitions);
+        for (size_type i = 0; i < partitions; ++i) {
+            parts.emplace_back(hash_fn, equal_fn);
+        }
+        file_prefix = "spill-" + std::to_string(std::random_device{}()) + "-";
+    }
+
+    SpillingHashMap(const SpillingHashMap &) = delete;
+
+    SpillingHashMap(SpillingHashMap &&) = default;
+
+    SpillingHashMap &operator=(const SpillingHashMap &) = delete;
+
+    // Deletes the spill files.
+    ~SpillingHashMap() {
+        remove_files();
+    }
+
+    // Inserts `value` for a new key, and otherwise replaces the value with
+    // `combine(old, value)`; the merge is deferred if the partition is spilled.
+    void update(const key_type &key, const mapped_type &value) {
+        Partition &part = parts[partition(key)];
+        if (part.spilled()) {
+            part.pending.push_back({key, value});
+            if (part.pending.size() == batch) {
+                write_pending(part);
+            }
+            return;
+        }
+        size_type before = footprint(part.table);
+        merge_into(part.table, key, value);
+        resident_bytes = resident_bytes + footprint(part.table) - before;
+        while (resident_bytes > budget && spill_largest()) {}
+    }
+
+    // Calls `f(key, value)` once per distinct key with all of its updates merged,
+    // resident partitions first. Each spilled partition is read sequentially into
+    // a temporary table, which must fit in memory.
+    template<class F>
+    void for_each(F f) {
+        for (auto &part : parts) {
+            if (!part.spilled()) {
+                for (const auto &kv : part.table) {
+                    f(kv.first, kv.second);
+                }
+            }
+        }
+        for (auto &part : parts) {
+            if (part.spilled()) {
+                table_type table(0, hash_fn, equal_fn);
+                load(part, table);
+                for (const auto &kv : table) {
+                    f(kv.first, kv.second);
+                }
+            }
+        }
+    }
+
+    // Drops all elements and deletes the spill files.
+    void clear() {
+        remove_files();
+        for (auto &part : parts) {
+            part = Partition(hash_fn, equal_fn);
+        }
+        resident_bytes = 0;
+    }
+
+    [[nodiscard]] size_type partition_count() const noexcept {
+        return parts.size();
+    }
+
+    [[nodiscard]] size_type spilled_partitions() const {
+        return std::count_if(parts.begin(), parts.end(), [](const Partition &part) {
+            return part.spilled();
+        });
+    }
+
+    // Elements of the resident partitions; spilled ones are only counted by
+    // `for_each`, since their files may repeat keys.
+    [[nodiscard]] size_type resident_size() const noexcept {
+        size_type total = 0;
+        for (const auto &part : parts) {
+            total += part.table.size();
+        }
+        return total;
+    }
+
+    // Records in the spill files, including buffered ones.
+    [[nodiscard]] size_type spilled_records() const noexcept {
+        size_type total = 0;
+        for (const auto &part : parts) {
+            total += part.records + part.pending.size();
+        }
+        return total;
+    }
+
+    [[nodiscard]] size_type memory_usage() const noexcept {
+        return resident_bytes;
+    }
+
+    [[nodiscard]] size_type memory_budget() const noexcept {
+        return budget;
+    }
+
+    // Records each spilled partition buffers before writing them out.
+    [[nodiscard]] size_type write_batch() const noexcept {
+        return batch;
+    }
+
+    [[nodiscard]] const std::filesystem::path &spill_directory() const noexcept {
+        return directory;
+    }
+};
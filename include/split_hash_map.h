@@ -0,0 +1,642 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Map with a struct-of-arrays layout: probing reads groups of eight control
+// bytes stored next to their eight keys, and the mapped values live in a
+// parallel array that is only touched once a key has matched, so a large `T`
+// no longer dilutes the probe path. A control byte holds 7 bits of the key's
+// hash (or marks the slot empty or deleted), which lets a whole group be
+// screened with a few word operations before any key is compared.
+// `CollisionPolicy` steps from group to group.
+template<
+        class Key,
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = std::hash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class SplitHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+    using reference = std::pair<const Key &, T &>;
+    using const_reference = std::pair<const Key &, const T &>;
+
+private:
+    static constexpr size_type group_size = 8;
+    static constexpr std::uint8_t empty_ctrl = 0x80;
+    static constexpr std::uint8_t deleted_ctrl = 0xFE;
+    static constexpr std::uint64_t low_bits = 0x0101010101010101ULL;
+    static constexpr std::uint64_t high_bits = 0x8080808080808080ULL;
+
+    // Control bytes are kept in one word, byte `i` at bits 8i..8i+7: a full slot
+    // has the top bit clear and the hash fragment below it.
+    struct Group {
+        std::uint64_t ctrl;
+        alignas(Key) unsigned char keys[group_size * sizeof(Key)];
+
+        Key *key(size_type i) noexcept {
+            return std::launder(reinterpret_cast<Key *>(keys + i * sizeof(Key)));
+        }
+
+        const Key *key(size_type i) const noexcept {
+            return std::launder(reinterpret_cast<const Key *>(keys + i * sizeof(Key)));
+        }
+
+        [[nodiscard]] std::uint8_t control(size_type i) const noexcept {
+            return static_cast<std::uint8_t>(ctrl >> (8 * i));
+        }
+
+        void set_control(size_type i, std::uint8_t c) noexcept {
+            ctrl = (ctrl & ~(std::uint64_t(0xFF) << (8 * i))) | (std::uint64_t(c) << (8 * i));
+        }
+
+        // Top bit of every byte equal to `fragment`; a borrow may add bytes above
+        // a real match, so candidates are confirmed with `control`.
+        [[nodiscard]] std::uint64_t match(std::uint8_t fragment) const noexcept {
+            std::uint64_t x = ctrl ^ (low_bits * fragment);
+            return (x - low_bits) & ~x & high_bits;
+        }
+
+        [[nodiscard]] std::uint64_t match_empty() const noexcept {
+            return ctrl & ~(ctrl << 6) & high_bits;
+        }
+
+        // Empty or deleted slots.
+        [[nodiscard]] std::uint64_t match_free() const noexcept {
+            return ctrl & high_bits;
+        }
+    };
+
+    struct Value {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    std::vector<Group> groups;
+    std::vector<Value> values;
+    size_type el_count = 0;
+    size_type del_count = 0;
+    hasher hash_fn;
+    key_equal equal_fn;
+
+    // Index of the lowest byte whose top bit is set in `mask`.
+    static size_type first_byte(std::uint64_t mask) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<size_type>(__builtin_ctzll(mask)) / 8;
+#else
+        size_type i = 0;
+        for (; (mask & 0xFF) == 0; mask >>= 8) {
+            ++i;
+        }
+        return i;
+#endif
+    }
+
+    static std::uint8_t fragment_of(size_type hash) noexcept {
+        return static_cast<std::uint8_t>(hash & 0x7F);
+    }
+
+    [[nodiscard]] bool is_live(size_type slot) const noexcept {
+        return groups[slot / group_size].control(slot % group_size) < empty_ctrl;
+    }
+
+    Key &key_at(size_type slot) noexcept {
+        return *groups[slot / group_size].key(slot % group_size);
+    }
+
+    const Key &key_at(size_type slot) const noexcept {
+        return *groups[slot / group_size].key(slot % group_size);
+    }
+
+    T &value_at(size_type slot) noexcept {
+        return *std::launder(reinterpret_cast<T *>(values[slot].bytes));
+    }
+
+    const T &value_at(size_type slot) const noexcept {
+        return *std::launder(reinterpret_cast<const T *>(values[slot].bytes));
+    }
+
+    template<class Map, class Ref>
+    class Basic_Iterator {
+        friend class SplitHashMap;
+
+        template<class, class>
+        friend class Basic_Iterator;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef std::pair<const Key, T> value_type;
+        typedef Ref reference;
+
+        struct pointer {
+            Ref ref;
+
+            Ref *operator->() noexcept {
+                return &ref;
+            }
+        };
+
+    private:
+        Map *map = nullptr;
+        size_type current{};
+
+        Basic_Iterator(Map *m, size_type ind) : map(m), current(ind) {
+            skip_free();
+        }
+
+        void skip_free() noexcept {
+            while (current < map->bucket_count() && !map->is_live(current)) {
+                ++current;
+            }
+        }
+
+        [[nodiscard]] bool at_end() const noexcept {
+            return map == nullptr || current >= map->bucket_count();
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        template<class OtherMap, class OtherRef>
+        Basic_Iterator(const Basic_Iterator<OtherMap, OtherRef> &other) : map(other.map), current(other.current) {}
+
+        reference operator*() const {
+            if (!at_end()) {
+                return reference(map->key_at(current), map->value_at(current));
+            }
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+
+        pointer operator->() const {
+            return pointer{operator*()};
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (!at_end()) {
+                ++current;
+                skip_free();
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator==(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return at_end() ? other.at_end() : !other.at_end() && current == other.current;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator!=(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return !(*this == other);
+        }
+    };
+
+public:
+    using iterator = Basic_Iterator<SplitHashMap, reference>;
+    using const_iterator = Basic_Iterator<const SplitHashMap, const_reference>;
+
+    explicit SplitHashMap(size_type expected_max_size = 0,
+                          const hasher &hash = hasher(),
+                          const key_equal &equal = key_equal()) : hash_fn(hash), equal_fn(equal) {
+        allocate(group_count_for(expected_max_size));
+    }
+
+    template<class InputIt>
+    SplitHashMap(InputIt first, InputIt last,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal()) : SplitHashMap(expected_max_size, hash, equal) {
+        insert(first, last);
+    }
+
+    SplitHashMap(std::initializer_list<value_type> init,
+                 size_type expected_max_size = 0,
+                 const hasher &hash = hasher(),
+                 const key_equal &equal = key_equal()) : SplitHashMap(init.begin(), init.end(), expected_max_size,
+                                                                      hash, equal) {}
+
+    // Copies keep the layout of `other`, so no element is rehashed.
+    SplitHashMap(const SplitHashMap &other) : hash_fn(other.hash_fn), equal_fn(other.equal_fn) {
+        allocate(other.groups.size());
+        for (size_type g = 0; g < groups.size(); ++g) {
+            groups[g].ctrl = other.groups[g].ctrl;
+        }
+        for (size_type slot = 0; slot < bucket_count(); ++slot) {
+            if (other.is_live(slot)) {
+                ::new(static_cast<void *>(&key_at(slot))) Key(other.key_at(slot));
+                ::new(static_cast<void *>(&value_at(slot))) T(other.value_at(slot));
+            }
+        }
+        el_count = other.el_count;
+        del_count = other.del_count;
+    }
+
+    SplitHashMap(SplitHashMap &&other) noexcept : groups(std::move(other.groups)), values(std::move(other.values)),
+                                                  el_count(other.el_count), del_count(other.del_count),
+                                                  hash_fn(other.hash_fn), equal_fn(other.equal_fn) {
+        other.groups.clear();
+        other.values.clear();
+        other.el_count = 0;
+        other.del_count = 0;
+    }
+
+    SplitHashMap &operator=(const SplitHashMap &other) {
+        if (this != &other) {
+            SplitHashMap t(other);
+            swap(t);
+        }
+        return *this;
+    }
+
+    SplitHashMap &operator=(SplitHashMap &&other) noexcept {
+        if (this != &other) {
+            destroy_all();
+            groups = std::move(other.groups);
+            values = std::move(other.values);
+            el_count = other.el_count;
+            del_count = other.del_count;
+            hash_fn = other.hash_fn;
+            equal_fn = other.equal_fn;
+            other.groups.clear();
+            other.values.clear();
+            other.el_count = 0;
+            other.del_count = 0;
+        }
+        return *this;
+    }
+
+    ~SplitHashMap() {
+        destroy_all();
+    }
+
+    void swap(SplitHashMap &other) noexcept {
+        std::swap(groups, other.groups);
+        std::swap(values, other.values);
+        std::swap(el_count, other.el_count);
+        std::swap(del_count, other.del_count);
+        std::swap(hash_fn, other.hash_fn);
+        std::swap(equal_fn, other.equal_fn);
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator();
+    }
+
+    const_iterator end() const noexcept {
+        return cend();
+    }
+
+    const_iterator cend() const noexcept {
+        return const_iterator();
+    }
+
+private:
+    // Groups needed to hold `count` elements at the maximum load factor.
+    static size_type group_count_for(size_type count) noexcept {
+        return std::max<size_type>(1, (count * 8 / 7 + group_size) / group_size);
+    }
+
+    void allocate(size_type group_count) {
+        groups.resize(group_count);
+        for (auto &group : groups) {
+            group.ctrl = low_bits * empty_ctrl;
+        }
+        values.resize(group_count * group_size);
+    }
+
+    void destroy(size_type slot) noexcept {
+        key_at(slot).~Key();
+        value_at(slot).~T();
+    }
+
+    void destroy_all() noexcept {
+        if (el_count == 0) {
+            return;
+        }
+        for (size_type slot = 0; slot < bucket_count(); ++slot) {
+            if (is_live(slot)) {
+                destroy(slot);
+            }
+        }
+    }
+
+    // Returns the slot holding `key` and `true`, or the first free slot on its
+    // probe sequence and `false`; `bucket_count()` means there is none.
+    [[nodiscard]] std::pair<size_type, bool> locate(const key_type &key, size_type hash) const {
+        if (groups.empty()) {
+            return {0, false};
+        }
+        std::uint8_t fragment = fragment_of(hash);
+        CollisionPolicy probing_local{};
+        size_type home = (hash >> 7) % groups.size();
+        size_type g = home;
+        size_type reusable = bucket_count();
+        for (size_type i = 0; i < groups.size(); ++i) {
+            const Group &group = groups[g];
+            for (auto candidates = group.match(fragment); candidates != 0; candidates &= candidates - 1) {
+                size_type j = first_byte(candidates);
+                if (group.control(j) == fragment && equal_fn(*group.key(j), key)) {
+                    return {g * group_size + j, true};
+                }
+            }
+            if (reusable == bucket_count()) {
+                if (auto free = group.match_free(); free != 0) {
+                    reusable = g * group_size + first_byte(free);
+                }
+            }
+            if (group.match_empty() != 0) {
+                return {reusable, false};
+            }
+            g = (home + probing_local.next()) % groups.size();
+        }
+        return {reusable, false};
+    }
+
+    void rebuild(size_type group_count) {
+        std::vector<Group> old_groups(std::move(groups));
+        std::vector<Value> old_values(std::move(values));
+        groups.clear();
+        values.clear();
+        allocate(std::max<size_type>(group_count, 1));
+        el_count = 0;
+        del_count = 0;
+        for (size_type g = 0; g < old_groups.size(); ++g) {
+            for (size_type j = 0; j < group_size; ++j) {
+                if (old_groups[g].control(j) >= empty_ctrl) {
+                    continue;
+                }
+                Key &key = *old_groups[g].key(j);
+                T &value = *std::launder(reinterpret_cast<T *>(old_values[g * group_size + j].bytes));
+                size_type hash = apply_hash(hash_fn, key);
+                auto place = locate(key, hash);
+                if (place.first == bucket_count()) {
+                    // Only reachable with a probing policy that skips groups.
+                    rebuild(groups.size() * 2);
+                    place = locate(key, hash);
+                }
+                ::new(static_cast<void *>(&key_at(place.first))) Key(std::move(key));
+                ::new(static_cast<void *>(&value_at(place.first))) T(std::move(value));
+                groups[place.first / group_size].set_control(place.first % group_size, fragment_of(hash));
+                ++el_count;
+                key.~Key();
+                value.~T();
+            }
+        }
+    }
+
+    // Finds `key` or claims a slot for it, constructing the key there; the mapped
+    // value of a claimed slot is left for the caller to construct.
+    template<class K>
+    std::pair<size_type, bool> claim(K &&key) {
+        size_type hash = apply_hash(hash_fn, key);
+        auto place = locate(key, hash);
+        if (place.second) {
+            return {place.first, false};
+        }
+        if ((size() + del_count + 1) * 8 > bucket_count() * 7) {
+            rebuild((size() + 1) * 16 > bucket_count() * 7 ? groups.size() * 2 : groups.size());
+            place = locate(key, hash);
+        }
+        while (place.first == bucket_count()) {
+            rebuild(groups.size() * 2);
+            place = locate(key, hash);
+        }
+        Group &group = groups[place.first / group_size];
+        size_type j = place.first % group_size;
+        ::new(static_cast<void *>(group.key(j))) Key(std::forward<K>(key));
+        if (group.control(j) == deleted_ctrl) {
+            --del_count;
+        }
+        group.set_control(j, fragment_of(hash));
+        ++el_count;
+        return {place.first, true};
+    }
+
+    // Frees a slot; a group that still has an empty slot was never passed over
+    // by a probe sequence, so its slots can become empty instead of deleted.
+    void release(size_type slot) noexcept {
+        Group &group = groups[slot / group_size];
+        if (group.match_empty() != 0) {
+            group.set_control(slot % group_size, empty_ctrl);
+        } else {
+            group.set_control(slot % group_size, deleted_ctrl);
+            ++del_count;
+        }
+        --el_count;
+    }
+
+    // Constructs the mapped value of a slot just claimed, giving the slot back if
+    // that throws.
+    template<class... Args>
+    void construct_value(size_type slot, Args &&... args) {
+        try {
+            ::new(static_cast<void *>(&value_at(slot))) T(std::forward<Args>(args)...);
+        } catch (...) {
+            key_at(slot).~Key();
+            release(slot);
+            throw;
+        }
+    }
+
+public:
+    std::pair<iterator, bool> insert(const value_type &inserted_value) {
+        return try_emplace(inserted_value.first, inserted_value.second);
+    }
+
+    template<class P>
+    std::pair<iterator, bool> insert(P &&inserted_value) {
+        return try_emplace(std::forward<P>(inserted_value).first, std::forward<P>(inserted_value).second);
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init) {
+        insert(init.begin(), init.end());
+    }
+
+    template<class K, class M>
+    std::pair<iterator, bool> insert_or_assign(K &&key, M &&inserted_value) {
+        auto place = claim(std::forward<K>(key));
+        if (place.second) {
+            construct_value(place.first, std::forward<M>(inserted_value));
+        } else {
+            value_at(place.first) = std::forward<M>(inserted_value);
+        }
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> try_emplace(K &&key, Args &&... args) {
+        auto place = claim(std::forward<K>(key));
+        if (place.second) {
+            construct_value(place.first, std::forward<Args>(args)...);
+        }
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class K, class... Args>
+    std::pair<iterator, bool> emplace(K &&key, Args &&... args) {
+        return try_emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+
+    iterator erase(const_iterator pos) {
+        if (pos == cend()) {
+            return end();
+        }
+        destroy(pos.current);
+        release(pos.current);
+        return iterator(this, pos.current);
+    }
+
+    size_type erase(const key_type &key) {
+        auto place = locate(key, apply_hash(hash_fn, key));
+        if (!place.second) {
+            return 0;
+        }
+        erase(const_iterator(this, place.first));
+        return 1;
+    }
+
+    [[nodiscard]] size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] iterator find(const key_type &key) {
+        auto place = locate(key, apply_hash(hash_fn, key));
+        return place.second ? iterator(this, place.first) : end();
+    }
+
+    [[nodiscard]] const_iterator find(const key_type &key) const {
+        auto place = locate(key, apply_hash(hash_fn, key));
+        return place.second ? const_iterator(this, place.first) : cend();
+    }
+
+    [[nodiscard]] bool contains(const key_type &key) const {
+        return locate(key, apply_hash(hash_fn, key)).second;
+    }
+
+    mapped_type &at(const key_type &key) {
+        auto place = locate(key, apply_hash(hash_fn, key));
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return value_at(place.first);
+    }
+
+    const mapped_type &at(const key_type &key) const {
+        auto place = locate(key, apply_hash(hash_fn, key));
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return value_at(place.first);
+    }
+
+    mapped_type &operator[](const key_type &key) {
+        return value_at(try_emplace(key).first.current);
+    }
+
+    mapped_type &operator[](key_type &&key) {
+        return value_at(try_emplace(std::move(key)).first.current);
+    }
+
+    // Destroys every element but keeps the allocated groups.
+    void clear() noexcept {
+        destroy_all();
+        for (auto &group : groups) {
+            group.ctrl = low_bits * empty_ctrl;
+        }
+        el_count = 0;
+        del_count = 0;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return values.max_size() / 8 * 7;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return groups.size() * group_size;
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return bucket_count() == 0 ? 0 : static_cast<float>(size()) / bucket_count();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 0.875;
+    }
+
+    // Makes room for at least `count` slots, dropping the deleted ones.
+    void rehash(size_type count) {
+        size_type group_count = (count + group_size - 1) / group_size;
+        if (group_count > groups.size() || del_count > size()) {
+            rebuild(std::max(groups.size(), group_count));
+        }
+    }
+
+    void reserve(size_type count) {
+        rehash(group_count_for(count) * group_size);
+    }
+
+    friend bool operator==(const SplitHashMap &first, const SplitHashMap &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (auto it = first.begin(); it != first.end(); ++it) {
+            auto place = second.locate(it->first, apply_hash(second.hash_fn, it->first));
+            if (!place.second || !(second.value_at(place.first) == it->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const SplitHashMap &first, const SplitHashMap &second) {
+        return !(first == second);
+    }
+};
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+// Fixed-capacity map whose operations are all `constexpr`, for lookup tables
+// that are known at compile time. Declared `constexpr`, the table is built by the
+// compiler into read-only data with no static initialization, and lookups of
+// constant keys can be folded away. Holds at most `N` elements in `2N + 1` slots;
+// keys and values must be literal, default constructible types.
+template<
+        class Key,
+        class T,
+        std::size_t N,
+        class CollisionPolicy = LinearProbing,
+        class Hash = StaticHash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class StaticHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+    // `std::pair` is not assignable in constant expressions before C++20.
+    struct value_type {
+        Key first{};
+        T second{};
+    };
+
+private:
+    static constexpr size_type slot_count = N * 2 + 1;
+
+    std::array<value_type, slot_count> slots{};
+    std::array<bool, slot_count> used{};
+    size_type el_count = 0;
+
+    // Returns the slot holding `key` and `true`, or the empty slot ending its
+    // probe sequence and `false`; `slot_count` means the sequence is exhausted.
+    [[nodiscard]] constexpr std::pair<size_type, bool> locate(const key_type &key) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        for (size_type i = 0; i < slot_count; ++i) {
+            if (!used[cur]) {
+                return {cur, false};
+            }
+            if (Equal()(slots[cur].first, key)) {
+                return {cur, true};
+            }
+            cur = (ind + probing_local.next()) % slot_count;
+        }
+        return {slot_count, false};
+    }
+
+public:
+    class const_iterator {
+        friend class StaticHashMap;
+
+        const StaticHashMap *map = nullptr;
+        size_type current{};
+
+        constexpr const_iterator(const StaticHashMap *m, size_type ind) : map(m), current(ind) {
+            while (current < slot_count && !map->used[current]) {
+                ++current;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef StaticHashMap::value_type value_type;
+        typedef const value_type *pointer;
+        typedef const value_type &reference;
+
+        constexpr const_iterator() = default;
+
+        constexpr reference operator*() const {
+            return map->slots[current];
+        }
+
+        constexpr pointer operator->() const {
+            return &map->slots[current];
+        }
+
+        constexpr const_iterator &operator++() {
+            *this = const_iterator(map, current + 1);
+            return *this;
+        }
+
+        constexpr const_iterator operator++(int) {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend constexpr bool operator==(const const_iterator &it1, const const_iterator &it2) {
+            return it1.current == it2.current;
+        }
+
+        friend constexpr bool operator!=(const const_iterator &it1, const const_iterator &it2) {
+            return !(it1 == it2);
+        }
+    };
+
+    using iterator = const_iterator;
+
+    constexpr StaticHashMap() = default;
+
+    // Later duplicates of a key are ignored, as with `insert`.
+    constexpr StaticHashMap(std::initializer_list<std::pair<Key, T>> init) {
+        for (const auto &element : init) {
+            insert(element.first, element.second);
+        }
+    }
+
+    // Returns `false` if `key` was already present. Exceeding the capacity throws,
+    // which in a constant expression is a compile error.
+    constexpr bool insert(const key_type &key, const mapped_type &value) {
+        auto place = locate(key);
+        if (place.second) {
+            return false;
+        }
+        if (el_count == N || place.first == slot_count) {
+            throw std::length_error("StaticHashMap capacity exceeded");
+        }
+        slots[place.first].first = key;
+        slots[place.first].second = value;
+        used[place.first] = true;
+        ++el_count;
+        return true;
+    }
+
+    // Value of `key`, or `nullptr`.
+    [[nodiscard]] constexpr const mapped_type *find(const key_type &key) const {
+        auto place = locate(key);
+        return place.second ? &slots[place.first].second : nullptr;
+    }
+
+    [[nodiscard]] constexpr bool contains(const key_type &key) const {
+        return locate(key).second;
+    }
+
+    [[nodiscard]] constexpr size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] constexpr const mapped_type &at(const key_type &key) const {
+        auto place = locate(key);
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return slots[place.first].second;
+    }
+
+    // Value of `key`, or `fallback` if it is absent.
+    [[nodiscard]] constexpr mapped_type get(const key_type &key, const mapped_type &fallback) const {
+        auto place = locate(key);
+        return place.second ? slots[place.first].second : fallback;
+    }
+
+    constexpr const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    constexpr const_iterator end() const {
+        return const_iterator(this, slot_count);
+    }
+
+    [[nodiscard]] constexpr size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] static constexpr size_type capacity() noexcept {
+        return N;
+    }
+
+    [[nodiscard]] static constexpr size_type bucket_count() noexcept {
+        return slot_count;
+    }
+
+    [[nodiscard]] constexpr size_type bucket(const key_type &key) const {
+        return Hash()(key) % slot_count;
+    }
+};
+
+// Deduces the capacity from the number of elements:
+// `constexpr auto m = make_static_hash_map<std::string_view, int>({{"a", 1}, {"b", 2}});`
+template<class Key, class T, std::size_t N>
+constexpr StaticHashMap<Key, T, N> make_static_hash_map(const std::pair<Key, T> (&init)[N]) {
+    StaticHashMap<Key, T, N> result;
+    for (const auto &element : init) {
+        result.insert(element.first, element.second);
+    }
+    return result;
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+// Set counterpart of StaticHashMap: a fixed-capacity table of at most `N` keys
+// whose operations are all `constexpr`, so it can be built at compile time.
+template<
+        class Key,
+        std::size_t N,
+        class CollisionPolicy = LinearProbing,
+        class Hash = StaticHash<Key>,
+        class Equal = std::equal_to<Key>
+>
+class StaticHashSet {
+public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = Equal;
+
+private:
+    static constexpr size_type slot_count = N * 2 + 1;
+
+    std::array<Key, slot_count> slots{};
+    std::array<bool, slot_count> used{};
+    size_type el_count = 0;
+
+    // Returns the slot holding `key` and `true`, or the empty slot ending its
+    // probe sequence and `false`; `slot_count` means the sequence is exhausted.
+    [[nodiscard]] constexpr std::pair<size_type, bool> locate(const key_type &key) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket(key);
+        size_type cur = ind;
+        for (size_type i = 0; i < slot_count; ++i) {
+            if (!used[cur]) {
+                return {cur, false};
+            }
+            if (Equal()(slots[cur], key)) {
+                return {cur, true};
+            }
+            cur = (ind + probing_local.next()) % slot_count;
+        }
+        return {slot_count, false};
+    }
+
+public:
+    class const_iterator {
+        friend class StaticHashSet;
+
+        const StaticHashSet *set = nullptr;
+        size_type current{};
+
+        constexpr const_iterator(const StaticHashSet *s, size_type ind) : set(s), current(ind) {
+            while (current < slot_count && !set->used[current]) {
+                ++current;
+            }
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef const Key value_type;
+        typedef const Key *pointer;
+        typedef const Key &reference;
+
+        constexpr const_iterator() = default;
+
+        constexpr reference operator*() const {
+            return set->slots[current];
+        }
+
+        constexpr pointer operator->() const {
+            return &set->slots[current];
+        }
+
+        constexpr const_iterator &operator++() {
+            *this = const_iterator(set, current + 1);
+            return *this;
+        }
+
+        constexpr const_iterator operator++(int) {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend constexpr bool operator==(const const_iterator &it1, const const_iterator &it2) {
+            return it1.current == it2.current;
+        }
+
+        friend constexpr bool operator!=(const const_iterator &it1, const const_iterator &it2) {
+            return !(it1 == it2);
+        }
+    };
+
+    using iterator = const_iterator;
+
+    constexpr StaticHashSet() = default;
+
+    constexpr StaticHashSet(std::initializer_list<Key> init) {
+        for (const auto &key : init) {
+            insert(key);
+        }
+    }
+
+    // Returns `false` if `key` was already present. Exceeding the capacity throws,
+    // which in a constant expression is a compile error.
+    constexpr bool insert(const key_type &key) {
+        auto place = locate(key);
+        if (place.second) {
+            return false;
+        }
+        if (el_count == N || place.first == slot_count) {
+            throw std::length_error("StaticHashSet capacity exceeded");
+        }
+        slots[place.first] = key;
+        used[place.first] = true;
+        ++el_count;
+        return true;
+    }
+
+    [[nodiscard]] constexpr bool contains(const key_type &key) const {
+        return locate(key).second;
+    }
+
+    [[nodiscard]] constexpr size_type count(const key_type &key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] constexpr const_iterator find(const key_type &key) const {
+        auto place = locate(key);
+        return place.second ? const_iterator(this, place.first) : end();
+    }
+
+    constexpr const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    constexpr const_iterator end() const {
+        return const_iterator(this, slot_count);
+    }
+
+    [[nodiscard]] constexpr size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] static constexpr size_type capacity() noexcept {
+        return N;
+    }
+
+    [[nodiscard]] static constexpr size_type bucket_count() noexcept {
+        return slot_count;
+    }
+
+    [[nodiscard]] constexpr size_type bucket(const key_type &key) const {
+        return Hash()(key) % slot_count;
+    }
+};
+
+// Deduces the capacity from the number of keys:
+// `constexpr auto s = make_static_hash_set<std::string_view>({"GET", "PUT"});`
+template<class Key, std::size_t N>
+constexpr StaticHashSet<Key, N> make_static_hash_set(const Key (&init)[N]) {
+    StaticHashSet<Key, N> result;
+    for (const auto &key : init) {
+        result.insert(key);
+    }
+    return result;
+}
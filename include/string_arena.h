@@ -0,0 +1,95 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Append-only storage for string bytes. Strings are copied into large chunks
+// that are never moved or freed before `clear`, so views returned by `store`
+// stay valid for the arena's lifetime, also across moves of the arena.
+class StringArena {
+public:
+    using size_type = std::size_t;
+
+    static constexpr size_type default_chunk_size = 1 << 16;
+
+private:
+    std::vector<std::unique_ptr<char[]>> chunks;
+    size_type chunk_size;
+    size_type used = 0;
+    size_type capacity = 0;
+    size_type total_used = 0;
+    size_type total_reserved = 0;
+
+public:
+    explicit StringArena(size_type chunk = default_chunk_size) : chunk_size(std::max<size_type>(chunk, 1)) {}
+
+    StringArena(const StringArena &) = delete;
+
+    StringArena &operator=(const StringArena &) = delete;
+
+    // Takes over the chunks of `other`, which is left empty.
+    StringArena(StringArena &&other) noexcept : chunks(std::move(other.chunks)), chunk_size(other.chunk_size),
+                                                used(std::exchange(other.used, 0)),
+                                                capacity(std::exchange(other.capacity, 0)),
+                                                total_used(std::exchange(other.total_used, 0)),
+                                                total_reserved(std::exchange(other.total_reserved, 0)) {
+        other.chunks.clear();
+    }
+
+    StringArena &operator=(StringArena &&other) noexcept {
+        if (this != &other) {
+            chunks = std::move(other.chunks);
+            other.chunks.clear();
+            chunk_size = other.chunk_size;
+            used = std::exchange(other.used, 0);
+            capacity = std::exchange(other.capacity, 0);
+            total_used = std::exchange(other.total_used, 0);
+            total_reserved = std::exchange(other.total_reserved, 0);
+        }
+        return *this;
+    }
+
+    // Copies `str` into the arena. Strings longer than a chunk get a chunk of
+    // their own.
+    std::string_view store(std::string_view str) {
+        if (str.empty()) {
+            return {};
+        }
+        if (capacity - used < str.size()) {
+            capacity = std::max(chunk_size, str.size());
+            chunks.push_back(std::make_unique<char[]>(capacity));
+            total_reserved += capacity;
+            used = 0;
+        }
+        char *dest = chunks.back().get() + used;
+        std::memcpy(dest, str.data(), str.size());
+        used += str.size();
+        total_used += str.size();
+        return {dest, str.size()};
+    }
+
+    // Frees all chunks; every view handed out before becomes dangling.
+    void clear() noexcept {
+        chunks.clear();
+        used = 0;
+        capacity = 0;
+        total_used = 0;
+        total_reserved = 0;
+    }
+
+    [[nodiscard]] size_type bytes_used() const noexcept {
+        return total_used;
+    }
+
+    [[nodiscard]] size_type bytes_reserved() const noexcept {
+        return total_reserved;
+    }
+
+    [[nodiscard]] size_type chunk_count() const noexcept {
+        return chunks.size();
+    }
+};
@@ -0,0 +1,483 @@
+#pragma once
+
+#include "hash_functions.h"
+#include "policy.h"
+#include "string_arena.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Map from strings to `T` that keeps key bytes in a StringArena. A slot only
+// holds a pointer into the arena, the key length and 32 bits of its hash, which
+// is compared before the bytes and reused when the table grows. Lookups take
+// `std::string_view`, so no temporary `std::string` is built. Bytes of erased
+// keys stay in the arena until `clear`. `T` must be default constructible.
+template<
+        class T,
+        class CollisionPolicy = LinearProbing,
+        class Hash = FastHash<std::string_view>
+>
+class StringHashMap {
+public:
+    using key_type = std::string_view;
+    using mapped_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using reference = std::pair<std::string_view, T &>;
+    using const_reference = std::pair<std::string_view, const T &>;
+
+private:
+    struct Slot {
+        const char *data = nullptr;
+        std::uint32_t length = 0;
+        std::uint32_t hash = 0;
+    };
+
+    // Addresses standing for the empty key and for erased slots; a null `data`
+    // marks a slot that was never used.
+    static inline const char markers[2] = {};
+
+    std::vector<Slot> slots;
+    std::vector<T> values;
+    StringArena arena;
+    size_type el_count;
+    size_type del_count;
+    hasher hash_fn;
+
+    template<class Map, class Ref>
+    class Basic_Iterator {
+        friend class StringHashMap;
+
+        template<class, class>
+        friend class Basic_Iterator;
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef std::pair<std::string_view, T> value_type;
+        typedef Ref reference;
+
+        struct pointer {
+            Ref ref;
+
+            Ref *operator->() noexcept {
+                return &ref;
+            }
+        };
+
+    private:
+        Map *map = nullptr;
+        size_type current{};
+
+        Basic_Iterator(Map *m, size_type ind) : map(m), current(ind) {
+            skip_free();
+        }
+
+        void skip_free() noexcept {
+            while (current < map->bucket_count() && !map->is_live(current)) {
+                ++current;
+            }
+        }
+
+        [[nodiscard]] bool at_end() const noexcept {
+            return map == nullptr || current >= map->bucket_count();
+        }
+
+    public:
+        Basic_Iterator() = default;
+
+        template<class OtherMap, class OtherRef>
+        Basic_Iterator(const Basic_Iterator<OtherMap, OtherRef> &other) : map(other.map), current(other.current) {}
+
+        reference operator*() const {
+            if (!at_end()) {
+                return reference(map->key_at(current), map->values[current]);
+            }
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+
+        pointer operator->() const {
+            return pointer{operator*()};
+        }
+
+        Basic_Iterator &operator++() noexcept {
+            if (!at_end()) {
+                ++current;
+                skip_free();
+            }
+            return *this;
+        }
+
+        const Basic_Iterator operator++(int) noexcept {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator==(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return at_end() ? other.at_end() : !other.at_end() && current == other.current;
+        }
+
+        template<class OtherMap, class OtherRef>
+        bool operator!=(const Basic_Iterator<OtherMap, OtherRef> &other) const {
+            return !(*this == other);
+        }
+    };
+
+public:
+    using iterator = Basic_Iterator<StringHashMap, reference>;
+    using const_iterator = Basic_Iterator<const StringHashMap, const_reference>;
+
+    explicit StringHashMap(size_type expected_max_size = 0,
+                           const hasher &hash = hasher(),
+                           size_type arena_chunk_size = StringArena::default_chunk_size)
+            : slots(expected_max_size * 2 + 1), values(expected_max_size * 2 + 1), arena(arena_chunk_size),
+              el_count(0), del_count(0), hash_fn(hash) {}
+
+    // Copies get an arena of their own holding only the live keys.
+    StringHashMap(const StringHashMap &other) : StringHashMap(other.size(), other.hash_fn) {
+        for (auto it = other.begin(); it != other.end(); ++it) {
+            insert_or_assign(it->first, it->second);
+        }
+    }
+
+    // Steals the table and the arena of `other`, which is left empty.
+    StringHashMap(StringHashMap &&other) noexcept : slots(std::move(other.slots)), values(std::move(other.values)),
+                                                    arena(std::move(other.arena)),
+                                                    el_count(std::exchange(other.el_count, 0)),
+                                                    del_count(std::exchange(other.del_count, 0)),
+                                                    hash_fn(other.hash_fn) {
+        other.reset();
+    }
+
+    StringHashMap &operator=(const StringHashMap &other) {
+        if (this != &other) {
+            StringHashMap tmp(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    StringHashMap &operator=(StringHashMap &&other) noexcept {
+        if (this != &other) {
+            slots = std::move(other.slots);
+            values = std::move(other.values);
+            arena = std::move(other.arena);
+            el_count = std::exchange(other.el_count, 0);
+            del_count = std::exchange(other.del_count, 0);
+            hash_fn = other.hash_fn;
+            other.reset();
+        }
+        return *this;
+    }
+
+    void swap(StringHashMap &other) noexcept {
+        std::swap(slots, other.slots);
+        std::swap(values, other.values);
+        std::swap(arena, other.arena);
+        std::swap(el_count, other.el_count);
+        std::swap(del_count, other.del_count);
+        std::swap(hash_fn, other.hash_fn);
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, 0);
+    }
+
+    const_iterator begin() const noexcept {
+        return cbegin();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return const_iterator(this, 0);
+    }
+
+    iterator end() noexcept {
+        return iterator();
+    }
+
+    const_iterator end() const noexcept {
+        return cend();
+    }
+
+    const_iterator cend() const noexcept {
+        return const_iterator();
+    }
+
+private:
+    // Leaves a moved-from map empty and without slots.
+    void reset() noexcept {
+        slots.clear();
+        values.clear();
+        el_count = 0;
+        del_count = 0;
+    }
+
+    [[nodiscard]] bool is_live(size_type ind) const noexcept {
+        return slots[ind].data != nullptr && slots[ind].data != markers + 1;
+    }
+
+    [[nodiscard]] std::string_view key_at(size_type ind) const noexcept {
+        return {slots[ind].data, slots[ind].length};
+    }
+
+    [[nodiscard]] std::uint32_t short_hash(std::string_view key) const {
+        std::uint64_t h = hash_fn(key);
+        return static_cast<std::uint32_t>(h ^ (h >> 32));
+    }
+
+    // Returns the slot holding `key` and `true`, or the first reusable slot on its
+    // probe sequence and `false`; `bucket_count()` means the sequence is exhausted.
+    [[nodiscard]] std::pair<size_type, bool> locate(std::string_view key, std::uint32_t hash) const {
+        CollisionPolicy probing_local{};
+        size_type ind = bucket_count() == 0 ? 0 : hash % bucket_count();
+        size_type cur = ind;
+        size_type reusable = bucket_count();
+        for (size_type i = 0; i < bucket_count(); ++i) {
+            const Slot &slot = slots[cur];
+            if (slot.data == nullptr) {
+                return {reusable == bucket_count() ? cur : reusable, false};
+            }
+            if (slot.data == markers + 1) {
+                if (reusable == bucket_count()) {
+                    reusable = cur;
+                }
+            } else if (slot.hash == hash && slot.length == key.size() &&
+                       (key.empty() || std::memcmp(slot.data, key.data(), key.size()) == 0)) {
+                return {cur, true};
+            }
+            cur = (ind + probing_local.next()) % bucket_count();
+        }
+        return {reusable, false};
+    }
+
+    // Moves slots into a table of `count` buckets using their stored hashes; no
+    // key is hashed or copied again.
+    void rebuild(size_type count) {
+        // A moved-from map has no slots; growing it from there starts at one.
+        count = std::max<size_type>(count, 1);
+        std::vector<Slot> old_slots(count);
+        std::vector<T> old_values(count);
+        std::swap(slots, old_slots);
+        std::swap(values, old_values);
+        el_count = 0;
+        del_count = 0;
+        for (size_type i = 0; i < old_slots.size(); ++i) {
+            const Slot &slot = old_slots[i];
+            if (slot.data != nullptr && slot.data != markers + 1) {
+                auto place = locate({slot.data, slot.length}, slot.hash);
+                if (place.first == bucket_count()) {
+                    rebuild(bucket_count() * 3);
+                    place = locate({slot.data, slot.length}, slot.hash);
+                }
+                slots[place.first] = slot;
+                values[place.first] = std::move(old_values[i]);
+                ++el_count;
+            }
+        }
+    }
+
+    // Finds `key` or copies it into the arena and claims a slot for it; the mapped
+    // value of a claimed slot is left for the caller to assign.
+    std::pair<size_type, bool> claim(std::string_view key) {
+        if (key.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("StringHashMap keys are limited to 2^32 - 1 bytes");
+        }
+        std::uint32_t hash = short_hash(key);
+        auto place = locate(key, hash);
+        if (place.second) {
+            return {place.first, false};
+        }
+        if ((size() + del_count + 1) * 2 > bucket_count()) {
+            rebuild((size() + 1) * 2 > bucket_count() ? bucket_count() * 3 : bucket_count());
+            place = locate(key, hash);
+        }
+        while (place.first == bucket_count()) {
+            rebuild(bucket_count() * 3);
+            place = locate(key, hash);
+        }
+        Slot &slot = slots[place.first];
+        if (slot.data == markers + 1) {
+            --del_count;
+        }
+        slot.data = key.empty() ? markers : arena.store(key).data();
+        slot.length = static_cast<std::uint32_t>(key.size());
+        slot.hash = hash;
+        ++el_count;
+        return {place.first, true};
+    }
+
+public:
+    template<class M>
+    std::pair<iterator, bool> insert_or_assign(std::string_view key, M &&inserted_value) {
+        auto place = claim(key);
+        values[place.first] = std::forward<M>(inserted_value);
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    template<class... Args>
+    std::pair<iterator, bool> try_emplace(std::string_view key, Args &&... args) {
+        auto place = claim(key);
+        if (place.second) {
+            values[place.first] = mapped_type(std::forward<Args>(args)...);
+        }
+        return std::make_pair(iterator(this, place.first), place.second);
+    }
+
+    std::pair<iterator, bool> insert(const std::pair<std::string_view, T> &inserted_value) {
+        return try_emplace(inserted_value.first, inserted_value.second);
+    }
+
+    template<class InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (auto it = first; it != last; ++it) {
+            insert(*it);
+        }
+    }
+
+    // Returns a view of the stored copy of `key`, adding it with a default value
+    // if it is new. The view stays valid until `clear` or destruction, also after
+    // the key is erased.
+    std::string_view intern(std::string_view key) {
+        auto place = claim(key);
+        if (place.second) {
+            values[place.first] = mapped_type();
+        }
+        return key_at(place.first);
+    }
+
+    iterator erase(const_iterator pos) {
+        if (pos == cend()) {
+            return end();
+        }
+        slots[pos.current].data = markers + 1;
+        values[pos.current] = mapped_type();
+        ++del_count;
+        --el_count;
+        return iterator(this, pos.current);
+    }
+
+    size_type erase(std::string_view key) {
+        auto place = locate(key, short_hash(key));
+        if (!place.second) {
+            return 0;
+        }
+        erase(const_iterator(this, place.first));
+        return 1;
+    }
+
+    [[nodiscard]] size_type count(std::string_view key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    [[nodiscard]] iterator find(std::string_view key) {
+        auto place = locate(key, short_hash(key));
+        return place.second ? iterator(this, place.first) : end();
+    }
+
+    [[nodiscard]] const_iterator find(std::string_view key) const {
+        auto place = locate(key, short_hash(key));
+        return place.second ? const_iterator(this, place.first) : cend();
+    }
+
+    [[nodiscard]] bool contains(std::string_view key) const {
+        return locate(key, short_hash(key)).second;
+    }
+
+    mapped_type &at(std::string_view key) {
+        auto place = locate(key, short_hash(key));
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return values[place.first];
+    }
+
+    const mapped_type &at(std::string_view key) const {
+        auto place = locate(key, short_hash(key));
+        if (!place.second) {
+            throw std::out_of_range("Trying to access a not existing element in the map");
+        }
+        return values[place.first];
+    }
+
+    mapped_type &operator[](std::string_view key) {
+        return values[try_emplace(key).first.current];
+    }
+
+    void clear() {
+        std::fill(slots.begin(), slots.end(), Slot());
+        std::fill(values.begin(), values.end(), mapped_type());
+        arena.clear();
+        el_count = 0;
+        del_count = 0;
+    }
+
+    [[nodiscard]] const StringArena &key_storage() const noexcept {
+        return arena;
+    }
+
+    [[nodiscard]] size_type size() const noexcept {
+        return el_count;
+    }
+
+    [[nodiscard]] bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    [[nodiscard]] size_type bucket_count() const noexcept {
+        return slots.size();
+    }
+
+    [[nodiscard]] size_type max_size() const noexcept {
+        return slots.max_size() / 2;
+    }
+
+    // A moved-from map has no slots; every key then maps to the (absent) slot 0.
+    [[nodiscard]] size_type bucket(std::string_view key) const {
+        return bucket_count() == 0 ? 0 : short_hash(key) % bucket_count();
+    }
+
+    [[nodiscard]] float load_factor() const {
+        return static_cast<float>(size()) / bucket_count();
+    }
+
+    [[nodiscard]] float max_load_factor() const noexcept {
+        return 0.5;
+    }
+
+    void rehash(const size_type count) {
+        if (count > bucket_count() || del_count > 0) {
+            rebuild(std::max(count, bucket_count()));
+        }
+    }
+
+    void reserve(size_type count) {
+        if (count * 2 + 1 > bucket_count()) {
+            rebuild(count * 2 + 1);
+        }
+    }
+
+    friend bool operator==(const StringHashMap &first, const StringHashMap &second) {
+        if (first.size() != second.size()) {
+            return false;
+        }
+        for (auto it = first.begin(); it != first.end(); ++it) {
+            auto el = second.find(it->first);
+            if (el == second.end() || !(el->second == it->second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    friend bool operator!=(const StringHashMap &first, const StringHashMap &second) {
+        return !(first == second);
+    }
+};
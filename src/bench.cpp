@@ -0,0 +1,323 @@
+#include "hash_map.h"
+#include "hash_set.h"
+#include "latency_histogram.h"
+#include "perf_counters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Times HashSet and HashMap operations for each probing policy and table size
+// and, where the CPU and kernel allow it, reports hardware counters per
+// operation, so that layout changes can be judged by cache and TLB misses
+// rather than by wall-clock time alone. With `--latency` it instead times every
+// operation of a mixed workload on growing tables and reports tail latencies.
+//
+// Usage: hash_bench [--latency] [size...]
+
+namespace {
+
+struct Keys {
+    std::vector<std::uint64_t> present;
+    std::vector<std::uint64_t> absent;
+};
+
+// Distinct random keys; `absent` never collides with `present`.
+Keys make_keys(std::size_t count, std::uint64_t seed) {
+    std::mt19937_64 gen(seed);
+    std::vector<std::uint64_t> all(count * 2);
+    for (auto &key : all) {
+        key = gen();
+    }
+    std::sort(all.begin(), all.end());
+    all.erase(std::unique(all.begin(), all.end()), all.end());
+    std::shuffle(all.begin(), all.end(), gen);
+    Keys keys;
+    keys.present.assign(all.begin(), all.begin() + std::min(count, all.size()));
+    keys.absent.assign(all.begin() + keys.present.size(), all.end());
+    return keys;
+}
+
+// Keeps the compiler from dropping lookups whose result is unused.
+volatile std::size_t sink;
+
+class Report {
+    PerfCounters &counters;
+
+public:
+    explicit Report(PerfCounters &c) : counters(c) {}
+
+    void header() const {
+        std::printf("%-8s %-10s %9s %-10s %9s", "table", "policy", "size", "op", "ns/op");
+        for (std::size_t i = 0; i < PerfCounters::event_count; ++i) {
+            auto event = static_cast<PerfEvent>(i);
+            if (counters.available(event)) {
+                std::printf(" %14s", PerfCounters::name(event));
+            }
+        }
+        std::printf("\n");
+    }
+
+    // Runs `body` once and prints its cost divided by `ops`.
+    template<class Body>
+    void measure(const char *table, const char *policy, std::size_t size, const char *op,
+                 std::size_t ops, Body body) {
+        auto start = std::chrono::steady_clock::now();
+        counters.start();
+        body();
+        counters.stop();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        auto sample = counters.read();
+        std::printf("%-8s %-10s %9zu %-10s %9.1f", table, policy, size, op, elapsed.count() / ops);
+        for (std::size_t i = 0; i < PerfCounters::event_count; ++i) {
+            auto event = static_cast<PerfEvent>(i);
+            if (!counters.available(event)) {
+                continue;
+            }
+            if (sample.has(event)) {
+                std::printf(" %14.2f", sample[event] / ops);
+            } else {
+                std::printf(" %14s", "-");
+            }
+        }
+        std::printf("\n");
+    }
+};
+
+template<class Set>
+void bench_set(Report &report, const char *policy, const Keys &keys) {
+    std::size_t n = keys.present.size();
+    Set set;
+    report.measure("HashSet", policy, n, "insert", n, [&] {
+        for (auto key : keys.present) {
+            set.insert(key);
+        }
+    });
+    report.measure("HashSet", policy, n, "find-hit", n, [&] {
+        std::size_t found = 0;
+        for (auto key : keys.present) {
+            found += set.contains(key);
+        }
+        sink = found;
+    });
+    report.measure("HashSet", policy, n, "find-miss", keys.absent.size(), [&] {
+        std::size_t found = 0;
+        for (auto key : keys.absent) {
+            found += set.contains(key);
+        }
+        sink = found;
+    });
+    report.measure("HashSet", policy, n, "erase", n, [&] {
+        for (auto key : keys.present) {
+            set.erase(key);
+        }
+    });
+}
+
+template<class Map>
+void bench_map(Report &report, const char *policy, const Keys &keys) {
+    std::size_t n = keys.present.size();
+    Map map;
+    report.measure("HashMap", policy, n, "insert", n, [&] {
+        for (auto key : keys.present) {
+            map.insert({key, key});
+        }
+    });
+    report.measure("HashMap", policy, n, "find-hit", n, [&] {
+        std::size_t sum = 0;
+        for (auto key : keys.present) {
+            auto it = map.find(key);
+            sum += it != map.end() ? it->second : 0;
+        }
+        sink = sum;
+    });
+    report.measure("HashMap", policy, n, "find-miss", keys.absent.size(), [&] {
+        std::size_t found = 0;
+        for (auto key : keys.absent) {
+            found += map.contains(key);
+        }
+        sink = found;
+    });
+    report.measure("HashMap", policy, n, "erase", n, [&] {
+        for (auto key : keys.present) {
+            map.erase(key);
+        }
+    });
+}
+
+void run_counters(const std::vector<std::size_t> &sizes) {
+    PerfCounters counters;
+    if (!counters.any_available()) {
+        std::fprintf(stderr, "hardware counters are unavailable (see /proc/sys/kernel/perf_event_paranoid), "
+                             "reporting time only\n");
+    }
+    Report report(counters);
+    report.header();
+    for (auto size : sizes) {
+        Keys keys = make_keys(size, size);
+        bench_set<HashSet<std::uint64_t, LinearProbing>>(report, "linear", keys);
+        bench_set<HashSet<std::uint64_t, QuadraticProbing>>(report, "quadratic", keys);
+        bench_map<HashMap<std::uint64_t, std::uint64_t, LinearProbing>>(report, "linear", keys);
+        bench_map<HashMap<std::uint64_t, std::uint64_t, QuadraticProbing>>(report, "quadratic", keys);
+    }
+}
+
+// Per-operation latencies of one table; operations that changed the bucket
+// count are also recorded under `rehash`, so pauses stand out from the tail.
+class LatencyReport {
+    enum Op {
+        Insert,
+        FindHit,
+        FindMiss,
+        Erase,
+        Rehash,
+        op_count,
+    };
+
+    static constexpr const char *names[op_count] = {"insert", "find-hit", "find-miss", "erase", "(rehash)"};
+
+    LatencyHistogram histograms[op_count];
+
+    using clock = std::chrono::steady_clock;
+
+    template<class Table, class Body>
+    void time(Op op, const Table &table, Body body) {
+        auto buckets = table.bucket_count();
+        auto start = clock::now();
+        body();
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+        histograms[op].record(elapsed);
+        if (table.bucket_count() != buckets) {
+            histograms[Rehash].record(elapsed);
+        }
+    }
+
+public:
+    // Inserts every key of `keys.present` into an empty `table`, in a mix of 40%
+    // inserts, 35% successful and 10% failed finds and 15% erases of live keys.
+    template<class Table, class Add>
+    void run(Table &table, const Keys &keys, Add add) {
+        std::mt19937_64 gen(keys.present.size());
+        std::vector<std::uint64_t> live;
+        live.reserve(keys.present.size());
+        std::size_t next = 0;
+        std::size_t miss = 0;
+        while (next < keys.present.size()) {
+            auto roll = gen() % 100;
+            if (roll < 40 || live.empty()) {
+                auto key = keys.present[next++];
+                time(Insert, table, [&] {
+                    add(table, key);
+                });
+                live.push_back(key);
+            } else if (roll < 75) {
+                auto key = live[gen() % live.size()];
+                time(FindHit, table, [&] {
+                    sink = table.contains(key);
+                });
+            } else if (roll < 85) {
+                auto key = keys.absent[miss++ % keys.absent.size()];
+                time(FindMiss, table, [&] {
+                    sink = table.contains(key);
+                });
+            } else {
+                auto pos = gen() % live.size();
+                auto key = live[pos];
+                live[pos] = live.back();
+                live.pop_back();
+                time(Erase, table, [&] {
+                    table.erase(key);
+                });
+            }
+        }
+    }
+
+    static void header() {
+        std::printf("%-8s %-10s %9s %-10s %9s %9s %9s %9s %11s\n", "table", "policy", "size", "op", "count",
+                    "p50 ns", "p99 ns", "p99.9 ns", "max ns");
+    }
+
+    void print(const char *table, const char *policy, std::size_t size) const {
+        for (int op = 0; op < op_count; ++op) {
+            const auto &h = histograms[op];
+            std::printf("%-8s %-10s %9zu %-10s %9llu %9llu %9llu %9llu %11llu\n", table, policy, size, names[op],
+                        static_cast<unsigned long long>(h.count()),
+                        static_cast<unsigned long long>(h.percentile(50)),
+                        static_cast<unsigned long long>(h.percentile(99)),
+                        static_cast<unsigned long long>(h.percentile(99.9)),
+                        static_cast<unsigned long long>(h.max()));
+        }
+    }
+};
+
+template<class Set>
+void latency_set(const char *policy, const Keys &keys) {
+    Set set;
+    LatencyReport report;
+    report.run(set, keys, [](Set &s, std::uint64_t key) {
+        s.insert(key);
+    });
+    report.print("HashSet", policy, keys.present.size());
+}
+
+template<class Map>
+void latency_map(const char *policy, const Keys &keys) {
+    Map map;
+    LatencyReport report;
+    report.run(map, keys, [](Map &m, std::uint64_t key) {
+        m.insert({key, key});
+    });
+    report.print("HashMap", policy, keys.present.size());
+}
+
+void run_latency(const std::vector<std::size_t> &sizes) {
+    LatencyHistogram overhead;
+    for (int i = 0; i < 10000; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        overhead.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    std::printf("timer overhead: p50 %llu ns, included in every sample\n",
+                static_cast<unsigned long long>(overhead.percentile(50)));
+    LatencyReport::header();
+    for (auto size : sizes) {
+        Keys keys = make_keys(size, size);
+        latency_set<HashSet<std::uint64_t, LinearProbing>>("linear", keys);
+        latency_set<HashSet<std::uint64_t, QuadraticProbing>>("quadratic", keys);
+        latency_map<HashMap<std::uint64_t, std::uint64_t, LinearProbing>>("linear", keys);
+        latency_map<HashMap<std::uint64_t, std::uint64_t, QuadraticProbing>>("quadratic", keys);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    bool latency = false;
+    std::vector<std::size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--latency") == 0) {
+            latency = true;
+            continue;
+        }
+        char *end;
+        unsigned long long size = std::strtoull(argv[i], &end, 10);
+        if (*end != '\0' || size == 0) {
+            std::fprintf(stderr, "usage: %s [--latency] [size...]\n", argv[0]);
+            return 2;
+        }
+        sizes.push_back(size);
+    }
+    if (sizes.empty()) {
+        sizes = {1 << 10, 1 << 16, 1 << 20};
+    }
+    if (latency) {
+        run_latency(sizes);
+    } else {
+        run_counters(sizes);
+    }
+}
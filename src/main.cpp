@@ -1,19 +1,252 @@
-#include "hash_set.h"
+#include "dense_hash_set.h"
 
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
 
-int main()
-{
-    HashSet<int> set;
-    while (std::cin) {
-        int x;
-        std::cin >> x;
-        if (set.contains(x)) {
-            std::cout << "*\n";
+// Reads whitespace separated integers from a file descriptor: regular files are
+// mapped into memory, pipes are consumed in large blocks.
+class IntReader {
+    static constexpr size_t block_size = 1 << 20;
+
+    int fd;
+    std::vector<char> buffer;
+    void *mapped = MAP_FAILED;
+    size_t mapped_size = 0;
+    const char *pos = nullptr;
+    const char *end = nullptr;
+    bool eof = false;
+
+    static bool is_space(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Keeps the unread tail [pos, end) and appends the next block after it.
+    bool refill() {
+        if (eof) {
+            return false;
+        }
+        if (mapped != MAP_FAILED) {
+            eof = true;
+            return false;
+        }
+        size_t left = end - pos;
+        if (left == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+        } else {
+            std::memmove(buffer.data(), pos, left);
+        }
+        ssize_t n;
+        do {
+            n = read(fd, buffer.data() + left, buffer.size() - left);
+        } while (n < 0 && errno == EINTR);
+        pos = buffer.data();
+        end = pos + left + (n > 0 ? n : 0);
+        if (n <= 0) {
+            eof = true;
+        }
+        return n > 0;
+    }
+
+    // Mirrors `std::cin >> x`: reads the longest numeric prefix of the token and
+    // returns where it ends, so that a trailing "abc" fails on the next call; null
+    // if there are no digits or the value overflows.
+    static const char *parse(const char *first, const char *last, int &x) {
+        bool negative = false;
+        if (first != last && (*first == '-' || *first == '+')) {
+            negative = *first == '-';
+            ++first;
+        }
+        const char *digits = first;
+        long long value = 0;
+        for (; first != last; ++first) {
+            unsigned digit = static_cast<unsigned char>(*first) - '0';
+            if (digit > 9) {
+                break;
+            }
+            value = value * 10 + digit;
+            if (value > static_cast<long long>(INT_MAX) + 1) {
+                return nullptr;
+            }
+        }
+        if (first == digits) {
+            return nullptr;
+        }
+        if (negative) {
+            value = -value;
+        }
+        if (value > INT_MAX) {
+            return nullptr;
+        }
+        x = static_cast<int>(value);
+        return first;
+    }
+
+public:
+    explicit IntReader(int descriptor) : fd(descriptor) {
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            mapped_size = st.st_size;
+            mapped = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+            pos = static_cast<const char *>(mapped);
+            end = pos + mapped_size;
+        } else {
+            buffer.resize(block_size);
+            pos = end = buffer.data();
+        }
+    }
+
+    IntReader(const IntReader &) = delete;
+
+    IntReader &operator=(const IntReader &) = delete;
+
+    ~IntReader() {
+        if (mapped != MAP_FAILED) {
+            munmap(mapped, mapped_size);
+        }
+    }
+
+    [[nodiscard]] size_t size_hint() const {
+        return mapped != MAP_FAILED ? mapped_size : 0;
+    }
+
+    bool next(int &x) {
+        while (true) {
+            while (pos != end && is_space(*pos)) {
+                ++pos;
+            }
+            if (pos != end) {
+                break;
+            }
+            if (!refill()) {
+                return false;
+            }
         }
-        else {
-            std::cout << "-\n";
+        const char *token_end = pos;
+        while (true) {
+            while (token_end != end && !is_space(*token_end)) {
+                ++token_end;
+            }
+            if (token_end != end || eof) {
+                break;
+            }
+            size_t offset = token_end - pos;
+            if (!refill()) {
+                token_end = end;
+                break;
+            }
+            token_end = pos + offset;
         }
-        set.insert(x);
+        const char *parsed = parse(pos, token_end, x);
+        if (parsed == nullptr) {
+            return false;
+        }
+        pos = parsed;
+        return true;
+    }
+};
+
+class OutputBuffer {
+    static constexpr size_t block_size = 1 << 16;
+
+    int fd;
+    char buffer[block_size];
+    size_t used = 0;
+
+public:
+    explicit OutputBuffer(int descriptor) : fd(descriptor) {}
+
+    OutputBuffer(const OutputBuffer &) = delete;
+
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    ~OutputBuffer() {
+        flush();
+    }
+
+    void put(const char *s, size_t n) {
+        if (used + n > block_size) {
+            flush();
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+    }
+
+    void flush() {
+        size_t done = 0;
+        while (done < used) {
+            ssize_t n = write(fd, buffer + done, used - done);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                break;
+            }
+            done += n;
+        }
+        used = 0;
+    }
+};
+
+// Deduplicating set over all of `int`: the two values DenseHashSet reserves
+// as markers are tracked separately.
+class SeenSet {
+    DenseHashSet<int> set;
+    bool seen_min = false;
+    bool seen_min_next = false;
+
+public:
+    explicit SeenSet(size_t expected_max_size) : set(INT_MIN, INT_MIN + 1, expected_max_size) {}
+
+    // Returns `true` if `x` was not seen before.
+    bool insert(int x) {
+        if (x == INT_MIN) {
+            return !std::exchange(seen_min, true);
+        }
+        if (x == INT_MIN + 1) {
+            return !std::exchange(seen_min_next, true);
+        }
+        return set.insert(x).second;
+    }
+};
+
+constexpr size_t max_presized_keys = size_t(1) << 22;
+
+int main(int argc, char **argv)
+{
+    bool stats = argc > 1 && std::strcmp(argv[1], "--stats") == 0;
+
+    IntReader input(STDIN_FILENO);
+    OutputBuffer output(STDOUT_FILENO);
+    // The file size only bounds the number of distinct keys from above; a large
+    // input with many repeats would allocate a huge table up front, so the hint
+    // is capped and the set grows past it when it has to.
+    SeenSet set(std::min<size_t>(input.size_hint() / 8, max_presized_keys));
+
+    auto start = std::chrono::steady_clock::now();
+    size_t keys = 0;
+    int x;
+    while (input.next(x)) {
+        output.put(set.insert(x) ? "-\n" : "*\n", 2);
+        ++keys;
+    }
+    output.flush();
+
+    if (stats) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::fprintf(stderr, "%zu keys in %.3f s, %.0f keys/s\n", keys, elapsed.count(),
+                     elapsed.count() > 0 ? keys / elapsed.count() : 0.0);
     }
 }